@@ -7,6 +7,13 @@
 #include <numeric>
 #include <sstream>
 #include <iomanip>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <iterator>
+#include "datagen.h"
+#include "device_io.h"
 
 using namespace std;
 
@@ -188,34 +195,128 @@ void saveToFile(const string& filename, const list<shared_ptr<ElectronicDevice>>
     cout << "Data saved to " << filename << endl;
 }
 
-// Функция изменения объекта через указатель
-void editDevice(ElectronicDevice* device) {
-    if (!device) return;
+// Функция изменения устройства каталога
+void editDevice(DeviceCatalog& catalog, DeviceId id) {
+    if (!catalog.contains(id)) return;
 
     cout << "Editing device: ";
-    device->display();
+    catalog.display(id, cout);
 
     double newPrice;
     string newModel, newApp;
 
     cout << "Enter new price: ";
     cin >> newPrice;
-    device->setPrice(newPrice);
+    catalog.setPrice(id, newPrice);
 
     cin.ignore();
     cout << "Enter new model: ";
     getline(cin, newModel);
-    device->setModel(newModel);
+    catalog.setModel(id, newModel);
 
     cout << "Enter new app to add: ";
     getline(cin, newApp);
-    device->addApp(newApp);
+    catalog.addApp(id, newApp);
 
     cout << "Device updated.\n";
 }
 
+// Id устройства для пользователя: "слот", после повторного использования слота - "слот:поколение"
+string formatHandle(DeviceHandle h) {
+    return h.generation ? to_string(h.id) + ":" + to_string(h.generation) : to_string(h.id);
+}
+
+bool parseHandle(const string& s, DeviceHandle& h) {
+    unsigned long id = 0, generation = 0;
+    size_t colon = s.find(':');
+    try {
+        size_t used;
+        id = stoul(s.substr(0, colon), &used);
+        if (used != (colon == string::npos ? s.size() : colon)) return false;
+        if (colon != string::npos) {
+            generation = stoul(s.substr(colon + 1), &used);
+            if (used != s.size() - colon - 1) return false;
+        }
+    } catch (const exception&) {
+        return false;
+    }
+    h = {DeviceId(id), uint32_t(generation)};
+    return true;
+}
+
+// Смартфон с наибольшей памятью; false - смартфонов нет
+bool maxMemoryPhone(const DeviceCatalog& catalog, DeviceId& id) {
+    const auto& phones = catalog.phones();
+    auto it = max_element(phones.begin(), phones.end(),
+                          [](const PhoneRecord& a, const PhoneRecord& b) { return a.memory < b.memory; });
+    if (it == phones.end()) return false;
+    id = it->common.id;
+    return true;
+}
+
+// Устройства, где установлено хотя бы одно из приложений "app1|app2|..."
+IdBitmap devicesWithApps(DeviceCatalog& catalog, const string& apps) {
+    IdBitmap found;
+    stringstream ss(apps);
+    string app;
+    while (getline(ss, app, '|')) {
+        found = IdBitmap::unite(found, catalog.index().byApp(catalog.appNames().find(app)));
+    }
+    return found;
+}
+
+void showDevices(const DeviceCatalog& catalog, const IdBitmap& ids) {
+    cout << "Found " << ids.size() << " device(s):\n";
+    ids.forEach([&](DeviceId id) { catalog.display(id, cout); });
+}
+
+// withIds - перед устройством его id для выбора
+void showSearch(const DeviceCatalog& catalog, const vector<SearchHit>& hits, bool withIds = false) {
+    static const char* fields[] = {"brand", "model", "app"};
+    cout << "Found " << hits.size() << " device(s), best matches first:\n";
+    for (const SearchHit& h : hits) {
+        if (withIds) cout << formatHandle(catalog.handle(h.id)) << ": ";
+        cout << "(" << fields[int(h.field)] << " \"" << catalog.name(h) << "\"";
+        if (h.kind == MatchKind::Prefix) cout << ", prefix";
+        if (h.kind == MatchKind::Fuzzy) cout << ", " << h.distance << " typo(s)";
+        cout << ") ";
+        catalog.display(h.id, cout);
+    }
+}
+
+// Выбор устройства по id. Каталог целиком не печатается: id можно найти
+// поиском по имени ("?текст", как в пункте 3 -> 5) или списком всех ("*").
+// false - отмена или устройство уже удалено
+bool selectDevice(DeviceCatalog& catalog, const char* action, DeviceId& id) {
+    string input;
+    for (;;) {
+        cout << "Device to " << action << " - enter its id (?text - search by name, * - list all): ";
+        cin >> ws;
+        if (!getline(cin, input)) return false;
+        if (input == "*") {
+            for (DeviceId d : catalog.order()) {
+                cout << formatHandle(catalog.handle(d)) << ": ";
+                catalog.display(d, cout);
+            }
+        } else if (input[0] == '?') {
+            size_t start = input.find_first_not_of(' ', 1), end = input.find_last_not_of(' ');
+            string query = start == string::npos ? string() : input.substr(start, end + 1 - start);
+            showSearch(catalog, catalog.search(query, 20), true);
+        } else {
+            break;
+        }
+    }
+    DeviceHandle h;
+    if (!parseHandle(input, h)) return false;
+    if (!catalog.resolve(h, id)) {
+        cout << "Device " << input << " no longer exists.\n";
+        return false;
+    }
+    return true;
+}
+
 // Основное меню
-void menu(list<shared_ptr<ElectronicDevice>>& devices) {
+void menu(DeviceCatalog& catalog) {
     int choice;
     do {
         cout << "\n========== Electronic Device Manager ==========\n";
@@ -237,29 +338,68 @@ void menu(list<shared_ptr<ElectronicDevice>>& devices) {
                 string filename;
                 cout << "Enter filename: ";
                 cin >> filename;
-                loadFromFile(filename, devices);
+                loadCatalog(filename, catalog);
                 break;
             }
             case 2: {
                 cout << "\n--- All Devices ---\n";
-                for (const auto& device : devices) {
-                    device->display();
+                for (DeviceId id : catalog.order()) {
+                    catalog.display(id, cout);
                 }
                 break;
             }
             case 3: {
                 int filterChoice;
-                cout << "Filter by:\n1. Price above\n2. OS\n3. App name\n";
+                cout << "Filter by:\n1. Price above\n2. OS\n3. App name\n4. Brand, OS and app together\n"
+                        "5. Search by name (brand, model or app; start of a word or with typos)\n";
                 cin >> filterChoice;
+                DeviceIndex& index = catalog.index();
                 if (filterChoice == 1) {
                     double minPrice;
                     cout << "Enter minimum price: ";
                     cin >> minPrice;
-                    auto it = copy_if(devices.begin(), devices.end(),
-                                      ostream_iterator<shared_ptr<ElectronicDevice>>(cout, "\n"),
-                                      [minPrice](const shared_ptr<ElectronicDevice>& d) {
-                                          return d->getPrice() > minPrice;
-                                      });
+                    index.price().forRange(minPrice, numeric_limits<double>::infinity(),
+                                           [&](DeviceId id) { catalog.display(id, cout); });
+                } else if (filterChoice == 2) {
+                    string os;
+                    cout << "Enter OS: ";
+                    cin >> ws;
+                    getline(cin, os);
+                    showDevices(catalog, index.byOs(catalog.oses().find(os)));
+                } else if (filterChoice == 3) {
+                    string apps;
+                    cout << "Enter app name (app1|app2 for any of them): ";
+                    cin >> ws;
+                    getline(cin, apps);
+                    showDevices(catalog, devicesWithApps(catalog, apps));
+                } else if (filterChoice == 4) {
+                    string brand, os, apps;
+                    cout << "Enter brand (- for any): ";
+                    cin >> ws;
+                    getline(cin, brand);
+                    cout << "Enter OS (- for any): ";
+                    getline(cin, os);
+                    cout << "Enter app name (- for any, app1|app2 for any of them): ";
+                    getline(cin, apps);
+                    vector<IdBitmap> sets;
+                    if (brand != "-") sets.push_back(index.byBrand(catalog.brands().find(brand)));
+                    if (os != "-") sets.push_back(index.byOs(catalog.oses().find(os)));
+                    if (apps != "-") sets.push_back(devicesWithApps(catalog, apps));
+                    if (sets.empty()) {
+                        for (DeviceId id : catalog.order()) catalog.display(id, cout);
+                        break;
+                    }
+                    // Пересекаем начиная с самого короткого списка
+                    sort(sets.begin(), sets.end(), [](const IdBitmap& a, const IdBitmap& b) { return a.size() < b.size(); });
+                    IdBitmap found = sets[0];
+                    for (size_t i = 1; i < sets.size(); ++i) found = IdBitmap::intersect(found, sets[i]);
+                    showDevices(catalog, found);
+                } else if (filterChoice == 5) {
+                    string query;
+                    cout << "Enter search text: ";
+                    cin >> ws;
+                    getline(cin, query);
+                    showSearch(catalog, catalog.search(query, 20));
                 }
                 break;
             }
@@ -268,17 +408,9 @@ void menu(list<shared_ptr<ElectronicDevice>>& devices) {
                 int sortChoice;
                 cin >> sortChoice;
                 if (sortChoice == 1) {
-                    devices.sort([](const shared_ptr<ElectronicDevice>& a,
-                                    const shared_ptr<ElectronicDevice>& b) {
-                        return a->getPrice() < b->getPrice();
-                    });
+                    catalog.sortByPrice();
                 } else if (sortChoice == 2) {
-                    devices.sort([](const shared_ptr<ElectronicDevice>& a,
-                                    const shared_ptr<ElectronicDevice>& b) {
-                        if (a->getBrand() != b->getBrand())
-                            return a->getBrand() < b->getBrand();
-                        return a->getPrice() > b->getPrice();
-                    });
+                    catalog.sortByBrandPrice();
                 }
                 cout << "Sorted.\n";
                 break;
@@ -288,35 +420,34 @@ void menu(list<shared_ptr<ElectronicDevice>>& devices) {
                 break;
             }
             case 6: {
-                int index = 0;
-                cout << "Select device to edit (0-" << devices.size()-1 << "):\n";
-                for (const auto& d : devices) {
-                    cout << index++ << ": ";
-                    d->display();
-                }
-                int idx;
-                cin >> idx;
-                if (idx >= 0 && idx < devices.size()) {
-                    auto it = devices.begin();
-                    advance(it, idx);
-                    editDevice(it->get());
-                }
+                DeviceId id;
+                if (selectDevice(catalog, "edit", id)) editDevice(catalog, id);
                 break;
             }
             case 7: {
-                int index = 0;
-                cout << "Select device to delete (0-" << devices.size()-1 << "):\n";
-                for (const auto& d : devices) {
-                    cout << index++ << ": ";
-                    d->display();
-                }
-                int idx;
-                cin >> idx;
-                if (idx >= 0 && idx < devices.size()) {
-                    auto it = devices.begin();
-                    advance(it, idx);
-                    devices.erase(it);
-                    cout << "Device deleted.\n";
+                cout << "Delete:\n1. One device\n2. All devices of a brand\n3. All devices cheaper than\n";
+                int deleteChoice;
+                cin >> deleteChoice;
+                if (deleteChoice == 1) {
+                    DeviceId id;
+                    if (selectDevice(catalog, "delete", id)) {
+                        catalog.remove(id);
+                        cout << "Device deleted.\n";
+                    }
+                } else if (deleteChoice == 2) {
+                    string brand;
+                    cout << "Enter brand: ";
+                    cin >> ws;
+                    getline(cin, brand);
+                    uint32_t code = catalog.brands().find(brand);
+                    size_t n = catalog.removeIf([&](DeviceId id) { return catalog.common(id).brand == code; });
+                    cout << "Deleted " << n << " device(s).\n";
+                } else if (deleteChoice == 3) {
+                    double maxPrice;
+                    cout << "Enter price: ";
+                    cin >> maxPrice;
+                    size_t n = catalog.removeIf([&](DeviceId id) { return catalog.common(id).price < maxPrice; });
+                    cout << "Deleted " << n << " device(s).\n";
                 }
                 break;
             }
@@ -324,68 +455,44 @@ void menu(list<shared_ptr<ElectronicDevice>>& devices) {
                 string filename;
                 cout << "Enter filename to save: ";
                 cin >> filename;
-                saveToFile(filename, devices);
+                saveCatalog(filename, catalog);
                 break;
             }
             case 9: {
                 cout << "\n--- Special Lambda Functions ---\n";
 
                 // 1. Поиск смартфона с наибольшей памятью
-                auto maxMemPhone = max_element(devices.begin(), devices.end(),
-                    [](const shared_ptr<ElectronicDevice>& a, const shared_ptr<ElectronicDevice>& b) {
-                        auto* sa = dynamic_cast<Smartphone*>(a.get());
-                        auto* sb = dynamic_cast<Smartphone*>(b.get());
-                        if (!sa) return true;
-                        if (!sb) return false;
-                        return sa->getMemory() < sb->getMemory();
-                    });
-                if (maxMemPhone != devices.end()) {
+                DeviceId maxPhone;
+                bool hasPhone = maxMemoryPhone(catalog, maxPhone);
+                if (hasPhone) {
                     cout << "Smartphone with max memory:\n";
-                    (*maxMemPhone)->display();
+                    catalog.display(maxPhone, cout);
                 }
 
                 // 2. Подсчёт ноутбуков с экраном > 15 дюймов
-                int countLaptops = count_if(devices.begin(), devices.end(),
-                    [](const shared_ptr<ElectronicDevice>& d) {
-                        auto* laptop = dynamic_cast<Laptop*>(d.get());
-                        return laptop && laptop->getScreenSize() > 15.0;
-                    });
+                const auto& laptops = catalog.laptops();
+                int countLaptops = count_if(laptops.begin(), laptops.end(),
+                    [](const LaptopRecord& l) { return l.screen > 15.0; });
                 cout << "Laptops with screen > 15\": " << countLaptops << endl;
 
-                // 3. Сортировка по цене
-                devices.sort([](const auto& a, const auto& b) {
-                    return a->getPrice() < b->getPrice();
-                });
+                // 3-4. Устройства дороже порога по возрастанию цены: индекс цен уже
+                // отсортирован, порядок показа всё равно заменит сортировка в п. 6
                 cout << "Devices sorted by price.\n";
-
-                // 4. Фильтр по цене
                 double minPrice;
                 cout << "Enter price threshold: ";
                 cin >> minPrice;
                 cout << "Devices above $" << minPrice << ":\n";
-                for (const auto& d : devices) {
-                    if (d->getPrice() > minPrice) d->display();
-                }
+                catalog.index().price().forRange(minPrice, numeric_limits<double>::infinity(),
+                                                 [&](DeviceId id) { catalog.display(id, cout); });
 
-                // 5. Поиск смартфона с максимальной памятью (альтернативный способ)
-                shared_ptr<Smartphone> maxPhone;
-                for (const auto& d : devices) {
-                    auto* phone = dynamic_cast<Smartphone*>(d.get());
-                    if (phone && (!maxPhone || phone->getMemory() > maxPhone->getMemory())) {
-                        maxPhone = dynamic_pointer_cast<Smartphone>(d);
-                    }
-                }
-                if (maxPhone) {
+                // 5. Смартфон с максимальной памятью (тот же проход по массиву смартфонов)
+                if (hasPhone) {
                     cout << "Max memory smartphone (alt method):\n";
-                    maxPhone->display();
+                    catalog.display(maxPhone, cout);
                 }
 
                 // 6. Сортировка по бренду и цене
-                devices.sort([](const auto& a, const auto& b) {
-                    if (a->getBrand() != b->getBrand())
-                        return a->getBrand() < b->getBrand();
-                    return a->getPrice() > b->getPrice();
-                });
+                catalog.sortByBrandPrice();
                 cout << "Sorted by brand (A-Z) then price (high-low).\n";
                 break;
             }
@@ -398,16 +505,243 @@ void menu(list<shared_ptr<ElectronicDevice>>& devices) {
     } while (choice != 0);
 }
 
-int main() {
+// ===== Бенчмарк: list<shared_ptr<ElectronicDevice>> против DeviceCatalog =====
+
+template <class F>
+double timeMs(F&& f) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int runCatalogBenchmark(int argc, char* argv[]) {
+    size_t n = 1000000;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--devices") && i + 1 < argc) n = stoul(argv[++i]);
+        else cerr << "Unknown option: " << argv[i] << endl;
+    }
+    // Те же устройства, что пишет datagen devices; строки для списка готовятся заранее
+    vector<DeviceSpec> data;
+    vector<vector<string>> appNames;
+    generateDevices(n, 42, [&](const DeviceSpec& d) {
+        data.push_back(d);
+        appNames.emplace_back(d.apps.begin(), d.apps.end());
+    });
+    const double threshold = 2500;
+
+    list<shared_ptr<ElectronicDevice>> devices;
+    DeviceCatalog catalog;
+    double buildList = timeMs([&] {
+        for (size_t i = 0; i < data.size(); ++i) {
+            const DeviceSpec& d = data[i];
+            string brand(d.brand);
+            if (d.phone)
+                devices.push_back(make_shared<Smartphone>(brand, d.model, d.priceCents / 100.0, appNames[i],
+                                                          string(d.os), d.memory));
+            else
+                devices.push_back(make_shared<Laptop>(brand, d.model, d.priceCents / 100.0, appNames[i], d.screen,
+                                                      d.battery));
+        }
+    });
+    double buildCatalog = timeMs([&] {
+        for (const DeviceSpec& d : data) {
+            if (d.phone) catalog.addSmartphone(d.brand, d.model, d.priceCents / 100.0, d.apps, d.os, d.memory);
+            else catalog.addLaptop(d.brand, d.model, d.priceCents / 100.0, d.apps, d.screen, d.battery);
+        }
+        catalog.index().price().flush();
+    });
+    // Ссылки на устройства списка в порядке добавления (итераторы переживают сортировку)
+    vector<list<shared_ptr<ElectronicDevice>>::iterator> positions;
+    for (auto it = devices.begin(); it != devices.end(); ++it) positions.push_back(it);
+
+    size_t listCount = 0, catalogCount = 0;
+    int listMem = 0, catalogMem = 0;
+    double filterList = timeMs([&] {
+        listCount = count_if(devices.begin(), devices.end(),
+                             [&](const shared_ptr<ElectronicDevice>& d) { return d->getPrice() > threshold; });
+    });
+    double filterCatalog = timeMs([&] {
+        catalog.index().price().forRange(threshold, numeric_limits<double>::infinity(),
+                                         [&](DeviceId) { catalogCount++; });
+    });
+    double maxList = timeMs([&] {
+        for (const auto& d : devices)
+            if (auto* phone = dynamic_cast<Smartphone*>(d.get())) listMem = max(listMem, phone->getMemory());
+    });
+    double maxCatalog = timeMs([&] {
+        DeviceId id;
+        if (maxMemoryPhone(catalog, id)) catalogMem = catalog.phone(id).memory;
+    });
+    size_t listLaptops = 0, catalogLaptops = 0;
+    double laptopsList = timeMs([&] {
+        listLaptops = count_if(devices.begin(), devices.end(), [](const shared_ptr<ElectronicDevice>& d) {
+            auto* laptop = dynamic_cast<Laptop*>(d.get());
+            return laptop && laptop->getScreenSize() > 15.0;
+        });
+    });
+    double laptopsCatalog = timeMs([&] {
+        const auto& laptops = catalog.laptops();
+        catalogLaptops = count_if(laptops.begin(), laptops.end(), [](const LaptopRecord& l) { return l.screen > 15.0; });
+    });
+    double sortList = timeMs([&] {
+        devices.sort([](const auto& a, const auto& b) { return a->getPrice() < b->getPrice(); });
+    });
+    double sortCatalog = timeMs([&] { catalog.sortByPrice(); });
+    double brandList = timeMs([&] {
+        devices.sort([](const auto& a, const auto& b) {
+            if (a->getBrand() != b->getBrand()) return a->getBrand() < b->getBrand();
+            return a->getPrice() > b->getPrice();
+        });
+    });
+    double brandCatalog = timeMs([&] { catalog.sortByBrandPrice(); });
+
+    // Индексы: ОС, приложение и их пересечение с брендом
+    size_t listOs = 0, listApp = 0, listAll = 0, indexOs = 0, indexApp = 0, indexAll = 0;
+    auto hasApp = [](const ElectronicDevice& d, const string& app) {
+        const vector<string>& apps = d.getInstalledApps();
+        return find(apps.begin(), apps.end(), app) != apps.end();
+    };
+    double osList = timeMs([&] {
+        for (const auto& d : devices) {
+            auto* phone = dynamic_cast<Smartphone*>(d.get());
+            listOs += phone && phone->getOS() == "iOS";
+        }
+    });
+    double appList = timeMs([&] {
+        for (const auto& d : devices) listApp += hasApp(*d, "Zoom");
+    });
+    double allList = timeMs([&] {
+        for (const auto& d : devices) {
+            auto* phone = dynamic_cast<Smartphone*>(d.get());
+            listAll += phone && phone->getBrand() == "Apple" && phone->getOS() == "iOS" && hasApp(*d, "Zoom");
+        }
+    });
+    DeviceIndex& index = catalog.index();
+    double osIndex = timeMs([&] { indexOs = index.byOs(catalog.oses().find("iOS")).toVector().size(); });
+    double appIndex = timeMs([&] { indexApp = index.byApp(catalog.appNames().find("Zoom")).toVector().size(); });
+    double allIndex = timeMs([&] {
+        IdBitmap found = IdBitmap::intersect(index.byBrand(catalog.brands().find("Apple")),
+                                             index.byOs(catalog.oses().find("iOS")));
+        indexAll = IdBitmap::intersect(found, index.byApp(catalog.appNames().find("Zoom"))).toVector().size();
+    });
+    // Поиск по модели: перебор списка против текстового индекса (первый запрос строит индекс)
+    size_t listPrefix = 0, listFuzzy = 0;
+    double prefixList = timeMs([&] {
+        for (const auto& d : devices) listPrefix += foldCase(d->getModel()).compare(0, 10, "model-4242") == 0;
+    });
+    double fuzzyList = timeMs([&] {
+        for (const auto& d : devices) listFuzzy += boundedEditDistance("modle-42424", foldCase(d->getModel()), 2) <= 2;
+    });
+    double searchBuild = timeMs([&] { catalog.syncSearch(); });
+    vector<SearchHit> prefixHits, fuzzyHits;
+    double prefixCatalog = timeMs([&] { prefixHits = catalog.search("model-4242", 20); });
+    double fuzzyCatalog = timeMs([&] { fuzzyHits = catalog.search("modle-42424", 20); });
+
+    // Удаление: каждое сотое по ссылке (итератор списка / id каталога), затем все дешевле 500 одним проходом
+    double deleteList = timeMs([&] {
+        for (size_t i = 0; i < positions.size(); i += 100) devices.erase(positions[i]);
+    });
+    double deleteCatalog = timeMs([&] {
+        for (size_t i = 0; i < n; i += 100) catalog.remove(DeviceId(i));
+    });
+    double cheapList = timeMs([&] {
+        devices.remove_if([](const shared_ptr<ElectronicDevice>& d) { return d->getPrice() < 500; });
+    });
+    double cheapCatalog = timeMs([&] {
+        catalog.removeIf([&](DeviceId id) { return catalog.common(id).price < 500; });
+    });
+
+    bool same = listCount == catalogCount && listMem == catalogMem && listLaptops == catalogLaptops &&
+                listOs == indexOs && listApp == indexApp && listAll == indexAll && devices.size() == catalog.size();
+    cout << "=== Device catalog benchmark: " << n << " devices ===" << endl;
+    cout << fixed << setprecision(1);
+    cout << left << setw(24) << "operation" << right << setw(12) << "list, ms" << setw(14) << "catalog, ms" << endl;
+    auto row = [](const char* name, double a, double b) {
+        cout << left << setw(24) << name << right << setw(12) << a << setw(14) << b << "  x" << a / b << endl;
+    };
+    row("build", buildList, buildCatalog);
+    row("price > 2500", filterList, filterCatalog);
+    row("max memory phone", maxList, maxCatalog);
+    row("laptops screen > 15", laptopsList, laptopsCatalog);
+    row("sort by price", sortList, sortCatalog);
+    row("sort by brand, price", brandList, brandCatalog);
+    row("OS = iOS", osList, osIndex);
+    row("app = Zoom", appList, appIndex);
+    row("Apple & iOS & Zoom", allList, allIndex);
+    row("search model prefix", prefixList, prefixCatalog);
+    row("search model, typos", fuzzyList, fuzzyCatalog);
+    row("delete 1% one by one", deleteList, deleteCatalog);
+    row("delete price < 500", cheapList, cheapCatalog);
+    cout << "Search index build (first query): " << searchBuild << " ms; found " << prefixHits.size() << " of "
+         << listPrefix << " and " << fuzzyHits.size() << " of " << listFuzzy << " (top 20 of all)" << endl;
+    cout << "Results " << (same ? "match" : "DIFFER") << endl;
+    return same ? 0 : 1;
+}
+
+// ===== Бенчмарк загрузки и сохранения: построчный ifstream/ofstream против device_io.h =====
+
+string readAll(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+int runIoBenchmark(int argc, char* argv[]) {
+    size_t n = 1000000;
+    string dir = ".";
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--devices") && i + 1 < argc) n = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else cerr << "Unknown option: " << argv[i] << endl;
+    }
+    string input = dir + "/bench_devices.txt", listOut = dir + "/bench_list_saved.txt",
+           textOut = dir + "/bench_catalog_saved.txt", binOut = dir + "/bench_catalog.bin",
+           binText = dir + "/bench_bin_saved.txt";
+    if (!generateDevicesText(input, n, 42)) {
+        cerr << "Cannot write file: " << input << endl;
+        return 1;
+    }
+
     list<shared_ptr<ElectronicDevice>> devices;
+    DeviceCatalog catalog, fromBinary;
+    double loadList = timeMs([&] { loadFromFile(input, devices); });
+    double saveList = timeMs([&] { saveToFile(listOut, devices); });
+    double loadText = timeMs([&] { loadCatalogText(input, catalog); });
+    double saveText = timeMs([&] { saveCatalogText(textOut, catalog); });
+    double saveBinary = timeMs([&] { saveCatalogBinary(binOut, catalog); });
+    double loadBinary = timeMs([&] { loadCatalogBinary(binOut, fromBinary); });
+    saveCatalogText(binText, fromBinary);
+
+    string saved = readAll(textOut);
+    bool same = devices.size() == catalog.size() && fromBinary.size() == catalog.size() &&
+                readAll(listOut) == saved && readAll(binText) == saved;
+    cout << "=== Device I/O benchmark: " << n << " devices ===" << endl;
+    cout << fixed << setprecision(1);
+    cout << left << setw(24) << "operation" << right << setw(12) << "list, ms" << setw(14) << "catalog, ms" << endl;
+    auto row = [](const char* name, double a, double b) {
+        cout << left << setw(24) << name << right << setw(12) << a << setw(14) << b << "  x" << a / b << endl;
+    };
+    row("load text", loadList, loadText);
+    row("save text", saveList, saveText);
+    row("save binary", saveList, saveBinary);
+    row("load binary", loadList, loadBinary);
+    cout << "Results " << (same ? "match" : "DIFFER") << endl;
+    for (const string& f : {input, listOut, textOut, binOut, binText}) remove(f.c_str());
+    return same ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "--bench")) return runCatalogBenchmark(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--bench-io")) return runIoBenchmark(argc, argv);
+
+    DeviceCatalog catalog;
 
     // Автозагрузка данных из файла (по умолчанию)
-    loadFromFile("devices.txt", devices);
+    loadCatalogText("devices.txt", catalog);
 
-    menu(devices);
+    menu(catalog);
 
     // Автосохранение при выходе
-    saveToFile("devices_saved.txt", devices);
+    saveCatalogText("devices_saved.txt", catalog);
 
     return 0;
 }
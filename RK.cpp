@@ -9,6 +9,23 @@
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <filesystem>
+#include <unordered_map>
+#include "bank_accrual.h"
+#include "bank_batch.h"
+#include "bank_journal.h"
+#include "bank_ledger.h"
+#include "bank_registry.h"
+#include "datagen.h"
 
 using namespace std;
 
@@ -20,12 +37,15 @@ protected:
     double balance;        // баланс
 
 public:
+    // false - операции без вывода в консоль (пакетная обработка, бенчмарки)
+    inline static bool verbose = true;
+
     // Конструктор
     BankAccount(string accNum, string name, double initialBalance = 0.0)
         : accountNumber(accNum), ownerName(name), balance(initialBalance) {
         if (initialBalance < 0) {
             balance = 0.0;
-            cout << "Начальный баланс не может быть отрицательным. Установлен в 0.0" << endl;
+            if (verbose) cout << "Начальный баланс не может быть отрицательным. Установлен в 0.0" << endl;
         }
     }
 
@@ -33,9 +53,9 @@ public:
     void deposit(double amount) {
         if (amount > 0) {
             balance += amount;
-            cout << "Успешно пополнено: " << amount << " руб." << endl;
+            if (verbose) cout << "Успешно пополнено: " << amount << " руб." << endl;
         } else {
-            cout << "Ошибка: сумма пополнения должна быть положительной." << endl;
+            if (verbose) cout << "Ошибка: сумма пополнения должна быть положительной." << endl;
         }
     }
 
@@ -43,13 +63,13 @@ public:
     bool withdraw(double amount) {
         if (amount > 0 && amount <= balance) {
             balance -= amount;
-            cout << "Успешно снято: " << amount << " руб." << endl;
+            if (verbose) cout << "Успешно снято: " << amount << " руб." << endl;
             return true;
         } else if (amount > balance) {
-            cout << "Ошибка: недостаточно средств на счете." << endl;
+            if (verbose) cout << "Ошибка: недостаточно средств на счете." << endl;
             return false;
         } else {
-            cout << "Ошибка: сумма снятия должна быть положительной." << endl;
+            if (verbose) cout << "Ошибка: сумма снятия должна быть положительной." << endl;
             return false;
         }
     }
@@ -82,7 +102,7 @@ public:
         : BankAccount(accNum, name, initialBalance), interestRate(rate) {
         if (rate < 0) {
             interestRate = 0.0;
-            cout << "Процентная ставка не может быть отрицательной. Установлена в 0.0%" << endl;
+            if (verbose) cout << "Процентная ставка не может быть отрицательной. Установлена в 0.0%" << endl;
         }
     }
 
@@ -90,8 +110,9 @@ public:
     void applyInterest() {
         double interest = balance * (interestRate / 100.0);
         balance += interest;
-        cout << "Начислены проценты: " << fixed << setprecision(2)
-             << interest << " руб. (ставка: " << interestRate << "%)" << endl;
+        if (verbose)
+            cout << "Начислены проценты: " << fixed << setprecision(2)
+                 << interest << " руб. (ставка: " << interestRate << "%)" << endl;
     }
 
     // Метод для получения процентной ставки
@@ -103,9 +124,9 @@ public:
     void setInterestRate(double rate) {
         if (rate >= 0) {
             interestRate = rate;
-            cout << "Процентная ставка изменена на: " << rate << "%" << endl;
+            if (verbose) cout << "Процентная ставка изменена на: " << rate << "%" << endl;
         } else {
-            cout << "Ошибка: процентная ставка не может быть отрицательной." << endl;
+            if (verbose) cout << "Ошибка: процентная ставка не может быть отрицательной." << endl;
         }
     }
 
@@ -119,7 +140,482 @@ public:
     }
 };
 
-int main() {
+// ===== Бенчмарк конкурентного журнала балансов =====
+
+// Номера счетов по закону Ципфа: P(k) ~ 1 / (k + 1)^s, счёт 0 - самый "горячий"
+class ZipfGenerator {
+public:
+    ZipfGenerator(size_t n, double s) : cdf(n) {
+        double sum = 0;
+        for (size_t k = 0; k < n; k++) {
+            sum += 1.0 / pow(double(k + 1), s);
+            cdf[k] = sum;
+        }
+        for (double& c : cdf) c /= sum;
+    }
+
+    size_t operator()(mt19937_64& rng) const {
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t k = lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        return min(k, cdf.size() - 1);
+    }
+
+private:
+    vector<double> cdf;
+};
+
+struct BenchOp {
+    LedgerOp op;
+    uint32_t from, to;
+    int64_t amount;  // копейки
+};
+
+// Операции одного потока: 40% пополнений, 40% снятий, 20% переводов.
+// zipf == nullptr - счета выбираются равномерно
+vector<BenchOp> makeWorkload(size_t ops, size_t accounts, const ZipfGenerator* zipf, uint64_t seed) {
+    mt19937_64 rng(seed);
+    auto pick = [&]() -> uint32_t {
+        return uint32_t(zipf ? (*zipf)(rng) : uniform_int_distribution<size_t>(0, accounts - 1)(rng));
+    };
+    vector<BenchOp> work(ops);
+    for (BenchOp& op : work) {
+        unsigned kind = unsigned(rng() % 10);
+        op.op = kind < 4 ? LedgerOp::Deposit : kind < 8 ? LedgerOp::Withdraw : LedgerOp::Transfer;
+        op.from = pick();
+        op.to = op.op == LedgerOp::Transfer ? pick() : op.from;
+        op.amount = int64_t(rng() % 100000) + 1;
+    }
+    return work;
+}
+
+struct RoundResult {
+    double opsPerSec;
+    bool balanced;  // сумма балансов сошлась с суммой пополнений и снятий
+};
+
+RoundResult runLedgerRound(size_t accounts, const vector<vector<BenchOp>>& work, LedgerLog* log) {
+    const int64_t initial = 100000;  // 1000 руб. на каждом счете
+    Ledger ledger(accounts, initial);
+    vector<int64_t> delta(work.size(), 0);
+    vector<thread> threads;
+    auto t0 = chrono::steady_clock::now();
+    for (size_t t = 0; t < work.size(); t++) {
+        threads.emplace_back([&, t] {
+            unique_ptr<LedgerLog::Writer> writer(log ? new LedgerLog::Writer(*log) : nullptr);
+            int64_t d = 0;
+            for (const BenchOp& op : work[t]) {
+                bool ok;
+                switch (op.op) {
+                    case LedgerOp::Deposit:
+                        ok = ledger.deposit(op.from, op.amount);
+                        if (ok) d += op.amount;
+                        break;
+                    case LedgerOp::Withdraw:
+                        ok = ledger.withdraw(op.from, op.amount);
+                        if (ok) d -= op.amount;
+                        break;
+                    default:
+                        ok = ledger.transfer(op.from, op.to, op.amount);
+                }
+                if (writer) writer->record(op.op, ok, op.from, op.to, op.amount);
+            }
+            delta[t] = d;
+        });
+    }
+    for (thread& th : threads) th.join();
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    size_t ops = 0;
+    int64_t expected = initial * int64_t(accounts);
+    for (size_t t = 0; t < work.size(); t++) {
+        ops += work[t].size();
+        expected += delta[t];
+    }
+    return {sec > 0 ? ops / sec : 0, ledger.total() == expected};
+}
+
+// RK --bench [--threads N] [--accounts N] [--ops N] [--log FILE]
+int runLedgerBenchmark(int argc, char* argv[]) {
+    size_t maxThreads = max(4u, thread::hardware_concurrency());
+    size_t accounts = 10000, ops = 1000000;
+    string logPath;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) maxThreads = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--accounts") && i + 1 < argc) accounts = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--ops") && i + 1 < argc) ops = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--log") && i + 1 < argc) logPath = argv[++i];
+        else cerr << "Неизвестный параметр: " << argv[i] << endl;
+    }
+    if (accounts < 2) accounts = 2;
+    if (maxThreads == 0) maxThreads = 1;
+
+    ofstream logFile;
+    unique_ptr<LedgerLog> log;
+    if (!logPath.empty()) {
+        logFile.open(logPath);
+        if (!logFile) {
+            cerr << "Не удалось открыть журнал: " << logPath << endl;
+            return 1;
+        }
+        log.reset(new LedgerLog(logFile));
+    }
+
+    cout << "=== Бенчмарк журнала балансов ===" << endl;
+    cout << "Счетов: " << accounts << ", операций на поток: " << ops
+         << (log ? ", журнал: " + logPath : string(", без журнала")) << endl;
+    const ZipfGenerator zipfGen(accounts, 0.99);
+    for (bool zipf : {false, true}) {
+        cout << "\n-- " << (zipf ? "горячие счета (Ципф, s=0.99)" : "равномерное распределение") << " --" << endl;
+        double base = 0;
+        vector<size_t> counts;  // 1, 2, 4, ... и ровно maxThreads в конце
+        for (size_t n = 1; n < maxThreads; n *= 2) counts.push_back(n);
+        counts.push_back(maxThreads);
+        for (size_t n : counts) {
+            vector<vector<BenchOp>> work;
+            for (size_t t = 0; t < n; t++) work.push_back(makeWorkload(ops, accounts, zipf ? &zipfGen : nullptr, 1000 + t));
+            RoundResult r = runLedgerRound(accounts, work, log.get());
+            if (n == 1) base = r.opsPerSec;
+            cout << setw(4) << n << " потоков: " << setw(12) << size_t(r.opsPerSec) << " оп/с, ускорение x"
+                 << fixed << setprecision(2) << (base > 0 ? r.opsPerSec / base : 0)
+                 << (r.balanced ? ", баланс сходится" : ", ОШИБКА: баланс не сходится") << endl;
+            cout.unsetf(ios::fixed);
+        }
+    }
+    if (log) {
+        log.reset();
+        cout << "\nЖурнал записан: " << logPath << endl;
+    }
+    return 0;
+}
+
+// ===== Бенчмарк начисления процентов =====
+
+// RK --bench-accrual [--accounts N] [--threads N] [--periods N]
+int runAccrualBenchmark(int argc, char* argv[]) {
+    size_t accounts = 2000000, periods = 3;
+    unsigned threads = 0;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--accounts") && i + 1 < argc) accounts = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = unsigned(stoul(argv[++i]));
+        else if (!strcmp(argv[i], "--periods") && i + 1 < argc) periods = stoul(argv[++i]);
+        else cerr << "Неизвестный параметр: " << argv[i] << endl;
+    }
+
+    // Одинаковые счета в двух представлениях: объекты и столбцы
+    const double rates[] = {4.0, 5.0, 7.5, 3.25};
+    mt19937_64 rng(42);
+    BankAccount::verbose = false;
+    vector<unique_ptr<BankAccount>> objects;
+    vector<BankAccount*> pointers;
+    SavingsStore store;
+    objects.reserve(accounts);
+    store.reserve(accounts);
+    for (size_t i = 0; i < accounts; i++) {
+        int64_t kopecks = int64_t(rng() % 10000000);  // до 100 000 руб.
+        double rate = rates[i % 4];
+        objects.emplace_back(new SavingsAccount("RU" + to_string(i), "Клиент " + to_string(i),
+                                                toRubles(kopecks), rate));
+        pointers.push_back(objects.back().get());
+        store.add(kopecks, toRatePpm(rate));
+    }
+
+    cout << "=== Бенчмарк начисления процентов ===" << endl;
+    cout << "Счетов: " << accounts << ", периодов: " << periods << endl;
+
+    auto t0 = chrono::steady_clock::now();
+    for (size_t p = 0; p < periods; p++)
+        for (BankAccount* a : pointers)
+            if (SavingsAccount* s = dynamic_cast<SavingsAccount*>(a)) s->applyInterest();
+    double objectSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    double storeSec = 0;
+    int64_t interest = 0;
+    for (size_t p = 0; p < periods; p++) {
+        AccrualResult r = accrueInterest(store, threads);
+        storeSec += r.seconds;
+        interest += r.interest;
+    }
+    BankAccount::verbose = true;
+
+    // double копит ошибку округления, фиксированная точка - нет
+    size_t differ = 0;
+    for (size_t i = 0; i < accounts; i++)
+        if (toKopecks(pointers[i]->getBalance()) != store.balance(i)) differ++;
+
+    double total = double(accounts) * periods;
+    cout << fixed << setprecision(3);
+    cout << "applyInterest() по BankAccount*: " << objectSec << " с, " << size_t(total / objectSec) << " счетов/с" << endl;
+    cout << "SavingsStore (столбцы):         " << storeSec << " с, " << size_t(total / storeSec) << " счетов/с" << endl;
+    cout << "Ускорение: x" << setprecision(1) << objectSec / storeSec << endl;
+    cout << setprecision(2) << "Начислено всего: " << toRubles(interest) << " руб." << endl;
+    cout << "Счетов, где double разошелся с точным расчетом: " << differ << endl;
+    cout.unsetf(ios::fixed);
+    return 0;
+}
+
+static bool sameState(const SavingsStore& a, const SavingsStore& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a.balance(i) != b.balance(i) || a.rate(i) != b.rate(i)) return false;
+    return true;
+}
+
+// Поток операций со случайными счетами; каждая возвращается после fdatasync
+static void runDurableOps(DurableBank& bank, size_t accounts, size_t ops, unsigned seed) {
+    mt19937_64 rng(seed);
+    for (size_t i = 0; i < ops; i++) {
+        uint32_t a = uint32_t(rng() % accounts);
+        int64_t amount = int64_t(rng() % 100000) + 1;
+        switch (rng() % 8) {
+            case 0: bank.applyInterest(a); break;
+            case 1: case 2: case 3: bank.withdraw(a, amount); break;
+            default: bank.deposit(a, amount); break;
+        }
+    }
+}
+
+// Закрывает bank и открывает заново из журнала; после вызова bank открыт
+static bool reopenAndCheck(DurableBank& bank, const string& dir, const SavingsStore& expected, const char* title) {
+    bank.close();
+    RecoveryStats rs;
+    if (!bank.open(dir, rs)) {
+        cerr << "Восстановление не удалось" << endl;
+        return false;
+    }
+    SavingsStore state;
+    bool same = bank.state(state) && sameState(state, expected);
+    cout << title << ": " << rs.seconds * 1000 << " мс, снимок на lsn " << rs.snapshotLsn
+         << ", записей из журнала " << rs.replayed;
+    if (rs.truncatedBytes) cout << ", отрезано " << rs.truncatedBytes << " байт хвоста";
+    cout << (same ? ", балансы совпадают" : ", БАЛАНСЫ РАСХОДЯТСЯ") << endl;
+    return same;
+}
+
+// Каталог бенчмарка стирается: годится только пустой или с одними файлами журнала
+static bool looksLikeJournalDir(const string& dir) {
+    error_code ec;
+    if (!filesystem::exists(dir, ec)) return true;
+    if (!filesystem::is_directory(dir, ec)) return false;
+    for (const auto& e : filesystem::directory_iterator(dir, ec)) {
+        string name = e.path().filename().string();
+        if (name.rfind("wal-", 0) != 0 && name != "snapshot.bin" && name != "snapshot.tmp") return false;
+    }
+    return !ec;
+}
+
+int runJournalBenchmark(int argc, char* argv[]) {
+    string dir = "bank_journal";
+    size_t accounts = 10000, ops = 200000, serialOps = 2000;
+    unsigned threads = 16;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else if (!strcmp(argv[i], "--accounts") && i + 1 < argc) accounts = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--ops") && i + 1 < argc) ops = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = unsigned(stoul(argv[++i]));
+        else if (!strcmp(argv[i], "--serial-ops") && i + 1 < argc) serialOps = stoul(argv[++i]);
+        else cerr << "Неизвестный параметр: " << argv[i] << endl;
+    }
+    threads = max(1u, threads);
+    if (!looksLikeJournalDir(dir)) {
+        cerr << "Каталог " << dir << " не пуст и не похож на журнал - укажите другой --dir" << endl;
+        return 1;
+    }
+    filesystem::remove_all(dir);
+
+    cout << "=== Бенчмарк журнала операций ===" << endl;
+    cout << "Каталог: " << dir << ", счетов: " << accounts << ", операций: " << ops
+         << ", потоков: " << threads << endl;
+    cout << fixed << setprecision(1);
+
+    DurableBank bank;
+    RecoveryStats rs;
+    if (!bank.open(dir, rs) || bank.openAccounts(accounts, 1000000, toRatePpm(5.0)) < 0) {
+        cerr << "Не удалось открыть журнал в " << dir << endl;
+        return 1;
+    }
+
+    // Один поток: каждая операция ждёт свой fdatasync
+    JournalStats before = bank.stats();
+    auto t0 = chrono::steady_clock::now();
+    runDurableOps(bank, accounts, serialOps, 1);
+    double serialSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    JournalStats after = bank.stats();
+    cout << "1 поток:   " << serialOps / serialSec << " оп/с, " << after.syncs - before.syncs << " fdatasync" << endl;
+
+    // Много потоков: записи ожидающих объединяются в одну группу
+    before = after;
+    t0 = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; t++)
+        pool.emplace_back(runDurableOps, ref(bank), accounts, ops / threads, t + 2);
+    for (auto& th : pool) th.join();
+    double groupSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    after = bank.stats();
+    size_t done = ops / threads * threads;
+    uint64_t syncs = after.syncs - before.syncs;
+    cout << threads << " потоков: " << done / groupSec << " оп/с, " << syncs << " fdatasync, "
+         << double(after.records - before.records) / max<uint64_t>(syncs, 1) << " записей на fdatasync" << endl;
+    cout << "Журнал: " << after.records << " записей, " << after.bytes / double(after.records) << " байт на запись" << endl;
+
+    // Восстановление: весь журнал, затем снимок + короткий хвост
+    SavingsStore expected;
+    if (!bank.state(expected)) {
+        cerr << "Ошибка журнала" << endl;
+        return 1;
+    }
+    cout << setprecision(2);
+    bool ok = reopenAndCheck(bank, dir, expected, "Восстановление без снимка");
+
+    bank.checkpoint();
+    runDurableOps(bank, accounts, 1000, 99);
+    ok = bank.state(expected) && ok;
+    ok = reopenAndCheck(bank, dir, expected, "Снимок + хвост журнала  ") && ok;
+
+    // Сбой посреди записи: в конце последнего сегмента обрывок записи (журнал закрыт)
+    bank.close();
+    string last;
+    for (const auto& e : filesystem::directory_iterator(dir)) {
+        string name = e.path().filename().string();
+        if (name.rfind("wal-", 0) == 0 && name > filesystem::path(last).filename().string()) last = e.path().string();
+    }
+    ofstream(last, ios::binary | ios::app).write("\x12\x34\x56\x78\x09\x00\x02", 7);
+    ok = reopenAndCheck(bank, dir, expected, "После оборванной записи ") && ok;
+    bank.close();
+    cout.unsetf(ios::fixed);
+    return ok ? 0 : 1;
+}
+
+int runRegistryBenchmark(int argc, char* argv[]) {
+    size_t accounts = 1000000, lookups = 5000000, baseline = 1000000;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--accounts") && i + 1 < argc) accounts = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--lookups") && i + 1 < argc) lookups = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) baseline = stoul(argv[++i]);
+        else cerr << "Неизвестный параметр: " << argv[i] << endl;
+    }
+    baseline = min(baseline, accounts);
+    size_t clients = accounts / 4 + 1;  // у клиента в среднем 4 счета
+
+    cout << "=== Бенчмарк реестра счетов ===" << endl;
+    cout << "Счетов: " << accounts << ", клиентов: " << clients << ", поисков: " << lookups << endl;
+    cout << fixed << setprecision(1);
+
+    auto t0 = chrono::steady_clock::now();
+    AccountRegistry registry;
+    registry.reserve(accounts);
+    for (size_t i = 0; i < accounts; i++) {
+        AccountKind kind = i % 2 ? AccountKind::Savings : AccountKind::Regular;
+        registry.add(accountNumberFor(i), "Клиент " + to_string(i % clients), 100000, kind, toRatePpm(5.0));
+    }
+    double buildSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    // Одни и те же номера для поиска в обеих структурах
+    mt19937_64 rng(7);
+    vector<string> keys(lookups);
+    for (string& k : keys) k = accountNumberFor(rng() % baseline);
+
+    t0 = chrono::steady_clock::now();
+    size_t found = 0;
+    for (const string& k : keys)
+        if (AccountRecord* r = registry.find(k)) found += r->deposit(100);
+    double findSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    RegistryMemory m = registry.memory();
+    cout << "AccountRegistry: загрузка " << buildSec << " с, поиск+пополнение "
+         << findSec * 1e9 / lookups << " нс, найдено " << found << endl;
+    cout << "Память: записи " << m.records / 1048576.0 << " МБ, индекс " << m.index / 1048576.0
+         << " МБ, имена " << m.names / 1048576.0 << " МБ (" << registry.owners() << " шт.), на счет "
+         << double(m.total()) / accounts << " байт" << endl;
+
+    // Для сравнения: объекты BankAccount и unordered_map<string, BankAccount*>
+    BankAccount::verbose = false;
+    t0 = chrono::steady_clock::now();
+    unordered_map<string, unique_ptr<BankAccount>> byNumber;
+    byNumber.reserve(baseline);
+    for (size_t i = 0; i < baseline; i++) {
+        string number = accountNumberFor(i);
+        string owner = "Клиент " + to_string(i % clients);
+        BankAccount* a = i % 2 ? new SavingsAccount(number, owner, 1000.0, 5.0) : new BankAccount(number, owner, 1000.0);
+        byNumber.emplace(number, unique_ptr<BankAccount>(a));
+    }
+    double mapBuildSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    t0 = chrono::steady_clock::now();
+    found = 0;
+    for (const string& k : keys) {
+        auto it = byNumber.find(k);
+        if (it != byNumber.end()) {
+            it->second->deposit(1.0);
+            found++;
+        }
+    }
+    double mapFindSec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    BankAccount::verbose = true;
+    cout << "unordered_map (" << baseline << " счетов): загрузка " << mapBuildSec << " с, поиск+пополнение "
+         << mapFindSec * 1e9 / lookups << " нс, найдено " << found << endl;
+    cout.unsetf(ios::fixed);
+    return 0;
+}
+
+// Файл операций для --batch: сначала OPEN всех счетов, затем случайная смесь
+int generateOps(int argc, char* argv[]) {
+    string path = argv[2];
+    size_t accounts = 100000, ops = 5000000;
+    uint64_t seed = 11;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--accounts") && i + 1 < argc) accounts = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--ops") && i + 1 < argc) ops = stoul(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = stoull(argv[++i]);
+        else cerr << "Неизвестный параметр: " << argv[i] << endl;
+    }
+    if (!generateBankOps(path, accounts, ops, seed)) {
+        cerr << "Не удалось записать файл: " << path << endl;
+        return 1;
+    }
+    cout << "Записано: " << accounts << " счетов, " << ops << " операций -> " << path << endl;
+    return 0;
+}
+
+int runBatch(int argc, char* argv[]) {
+    string path = argv[2], outPath = "results.csv";
+    unsigned threads = 0;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = unsigned(stoul(argv[++i]));
+        else cerr << "Неизвестный параметр: " << argv[i] << endl;
+    }
+    MappedFile in(path);
+    if (!in.isOpen()) {
+        cerr << "Не удалось открыть файл: " << path << endl;
+        return 1;
+    }
+    ofstream out(outPath, ios::binary);
+    if (!out) {
+        cerr << "Не удалось создать файл: " << outPath << endl;
+        return 1;
+    }
+    BatchProcessor processor(out, threads);
+    BatchStats st = processor.run(in.view());
+    out.close();
+
+    cout << "=== Пакетная обработка операций ===" << endl;
+    cout << "Файл: " << path << " -> " << outPath << endl;
+    cout << "Операций: " << st.ops << ", выполнено: " << st.ok << ", отклонено: " << st.rejected << endl;
+    cout << fixed << setprecision(2) << "Время: " << st.seconds << " с, " << setprecision(0) << st.ops / st.seconds
+         << " оп/с" << endl;
+    cout << setprecision(1) << "Задержка операции: p50 " << st.p50Ns / 1000.0 << " мкс, p99 " << st.p99Ns / 1000.0
+         << " мкс" << endl;
+    cout.unsetf(ios::fixed);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "--bench")) return runLedgerBenchmark(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--bench-accrual")) return runAccrualBenchmark(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--bench-journal")) return runJournalBenchmark(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "--bench-registry")) return runRegistryBenchmark(argc, argv);
+    if (argc > 2 && !strcmp(argv[1], "--gen-ops")) return generateOps(argc, argv);
+    if (argc > 2 && !strcmp(argv[1], "--batch")) return runBatch(argc, argv);
+
     cout << "=== Моделирование работы банка ===\n" << endl;
 
     // Создание обычного банковского счета
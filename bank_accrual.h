@@ -0,0 +1,102 @@
+#pragma once
+
+// Пакетное начисление процентов по сберегательным счетам.
+// Счета хранятся столбцами (struct-of-arrays): баланс в копейках (int64)
+// и ставка в миллионных долях (ppm, 5% = 50000). Проценты считаются в целых
+// числах: balance * ppm / 1e6 с округлением к чётному (банковское), поэтому
+// результат детерминирован и не зависит от числа потоков и порядка.
+// Проход без ветвлений, по непрерывным массивам; диапазон делится между потоками.
+// Ограничение: |balance| * ppm < 9.2e18 (при ставке 100% - до 9.2e12 копеек).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+constexpr int64_t kRateScale = 1000000; // ppm
+
+// Ставка в процентах -> ppm
+inline int32_t toRatePpm(double percent) {
+    return static_cast<int32_t>(percent * (kRateScale / 100) + (percent < 0 ? -0.5 : 0.5));
+}
+
+// Проценты за период: balance * ratePpm / 1e6, округление половины к чётному
+inline int64_t interestFor(int64_t kopecks, int32_t ratePpm) {
+    int64_t p = kopecks * ratePpm;
+    int64_t q = p / kRateScale;
+    int64_t rem = p - q * kRateScale;
+    int64_t twice = 2 * (rem < 0 ? -rem : rem);
+    int64_t up = (twice > kRateScale) | ((twice == kRateScale) & (q & 1));
+    return q + (p < 0 ? -up : up);
+}
+
+class SavingsStore {
+public:
+    size_t add(int64_t kopecks, int32_t ratePpm) {
+        kopecks_.push_back(kopecks);
+        ratePpm_.push_back(ratePpm);
+        return kopecks_.size() - 1;
+    }
+
+    void reserve(size_t n) {
+        kopecks_.reserve(n);
+        ratePpm_.reserve(n);
+    }
+
+    size_t size() const { return kopecks_.size(); }
+    int64_t balance(size_t i) const { return kopecks_[i]; }
+    int32_t rate(size_t i) const { return ratePpm_[i]; }
+    void setRate(size_t i, int32_t ratePpm) { ratePpm_[i] = ratePpm; }
+
+    int64_t* balances() { return kopecks_.data(); }
+    const int32_t* rates() const { return ratePpm_.data(); }
+
+private:
+    std::vector<int64_t> kopecks_;
+    std::vector<int32_t> ratePpm_;
+};
+
+struct AccrualResult {
+    size_t accounts = 0;
+    int64_t interest = 0;  // сумма начисленного, копейки
+    double seconds = 0;
+};
+
+// Начисляет проценты по диапазону [from, to); возвращает сумму начисленного
+inline int64_t accrueRange(int64_t* kopecks, const int32_t* ratePpm, size_t from, size_t to) {
+    int64_t total = 0;
+    for (size_t i = from; i < to; ++i) {
+        int64_t interest = interestFor(kopecks[i], ratePpm[i]);
+        kopecks[i] += interest;
+        total += interest;
+    }
+    return total;
+}
+
+// Один период по всем счетам; threads = 0 - по числу ядер
+inline AccrualResult accrueInterest(SavingsStore& store, unsigned threads = 0) {
+    const size_t kMinChunk = 1 << 16; // мелкие диапазоны не стоят запуска потока
+    AccrualResult r;
+    r.accounts = store.size();
+    auto t0 = std::chrono::steady_clock::now();
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, r.accounts / kMinChunk + 1));
+
+    int64_t* kopecks = store.balances();
+    const int32_t* rates = store.rates();
+    if (threads == 1) {
+        r.interest = accrueRange(kopecks, rates, 0, r.accounts);
+    } else {
+        std::vector<int64_t> partial(threads);
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; ++t) {
+            size_t from = r.accounts * t / threads, to = r.accounts * (t + 1) / threads;
+            pool.emplace_back([=, &partial] { partial[t] = accrueRange(kopecks, rates, from, to); });
+        }
+        for (auto& th : pool) th.join();
+        for (int64_t p : partial) r.interest += p;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return r;
+}
@@ -0,0 +1,381 @@
+#pragma once
+
+// Пакетная обработка файла операций над счетами.
+// Формат (CSV, поле 0 - операция, поле 1 - номер счета):
+//   OPEN,<счет>,<баланс>,<владелец>[,<ставка %>]   (со ставкой - сберегательный)
+//   DEPOSIT,<счет>,<сумма>    WITHDRAW,<счет>,<сумма>
+//   TRANSFER,<счет>,<сумма>,<счет получателя>
+//   ACCRUE,<счет>             RATE,<счет>,<ставка %>
+// Файл читается через mmap + CsvReader без копирования строк. Счета
+// разбиты на шарды по хешу номера; у каждого шарда свой поток и свой
+// AccountRegistry, поэтому операции одного счёта выполняются строго в
+// порядке файла и без блокировок на данных счёта. Перевод списывает деньги
+// в шарде отправителя и отправляет зачисление в шард получателя; открыт ли
+// получатель к строке перевода, решает читатель (счета только открываются).
+// Читатель же нумерует зачисления каждого шарда в порядке файла, и перед
+// строкой шард применяет (дождавшись) все зачисления из более ранних строк;
+// при отказе в списании отправитель шлёт пустое зачисление. Поэтому
+// результат не зависит от числа потоков (порядок строк в файле - зависит).
+// Результат - CSV "line,op,account,status,detail": для OK в detail баланс
+// после операции (у перевода - баланс получателя), для REJECTED - причина.
+
+#include "bank_ledger.h"
+#include "bank_registry.h"
+#include "csv_reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+enum class BatchOpType : uint8_t { Open, Deposit, Withdraw, Transfer, Accrue, Rate, Credit };
+
+struct BatchOp {
+    BatchOpType type = BatchOpType::Open;
+    bool savings = false;    // для Open
+    bool targetOpen = false; // Transfer: получатель открыт раньше этой строки
+    int32_t ratePpm = 0;     // Open, Rate
+    int64_t amount = 0;      // копейки
+    uint64_t line = 0;
+    int64_t startNs = 0;     // момент чтения строки, для задержки
+    uint64_t creditsBefore = 0; // зачислений в шард этой строки из более ранних строк
+    uint64_t creditSeq = 0;     // Transfer в другой шард, Credit: номер зачисления у получателя
+    AccountNumber account, target;
+    std::string_view owner;  // указывает в отображённый файл
+};
+
+struct BatchStats {
+    size_t ops = 0, ok = 0, rejected = 0;
+    double seconds = 0;
+    int64_t p50Ns = 0, p99Ns = 0;
+};
+
+class BatchProcessor {
+public:
+    static constexpr size_t kReadBatch = 1024;     // строк на одну передачу в шард
+    static constexpr size_t kQueueLimit = 8192;    // дальше читатель ждёт
+    static constexpr size_t kOutFlush = 1 << 20;
+    static constexpr size_t kCreditFlush = 64;     // строк между отправками зачислений
+
+    // shards = 0 - по числу ядер
+    BatchProcessor(std::ostream& out, unsigned shards = 0) : out_(out) {
+        if (shards == 0) shards = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < shards; ++i) shards_.emplace_back(new Shard);
+    }
+
+    BatchStats run(std::string_view data) {
+        auto t0 = std::chrono::steady_clock::now();
+        out_ << "line,op,account,status,detail\n";
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < shards_.size(); ++i) workers.emplace_back([this, i] { work(i); });
+
+        Shard reader;            // ошибки разбора пишутся сюда
+        AccountRegistry opened;  // счета, открытые к текущей строке
+        std::vector<std::vector<BatchOp>> batches(shards_.size());
+        std::vector<uint64_t> incoming(shards_.size()); // пронумерованных зачислений по шардам
+        CsvRow row;
+        CsvReader csv(data);
+        uint64_t line = 0;
+        while (csv.next(row)) {
+            ++line;
+            if (row.size() == 1 && row[0].empty()) continue;
+            if (line == 1 && row[0] == "op") continue; // заголовок
+            BatchOp op;
+            op.line = line;
+            op.startNs = nowNs();
+            if (const char* err = parse(row, op)) {
+                write(reader, op, row[0], row.size() > 1 ? row[1] : std::string_view(), false, err);
+                flushOut(reader, false);
+                continue;
+            }
+            if (op.type == BatchOpType::Open) opened.add(op.account, std::string_view(), 0, AccountKind::Regular, 0);
+            if (op.type == BatchOpType::Transfer) op.targetOpen = opened.find(op.target) != nullptr;
+            size_t s = shardOf(op.account);
+            op.creditsBefore = incoming[s];
+            if (crossShard(op)) op.creditSeq = incoming[shardOf(op.target)]++;
+            batches[s].push_back(op);
+            if (batches[s].size() == kReadBatch) pushAll(batches, nullptr);
+        }
+        pushAll(batches, &incoming);
+        for (auto& w : workers) w.join();
+        flushOut(reader, true);
+
+        BatchStats st;
+        st.ok = reader.ok;
+        st.rejected = reader.rejected;
+        std::vector<int64_t> latency = std::move(reader.latency);
+        for (auto& s : shards_) {
+            st.ok += s->ok;
+            st.rejected += s->rejected;
+            latency.insert(latency.end(), s->latency.begin(), s->latency.end());
+        }
+        st.ops = st.ok + st.rejected;
+        st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!latency.empty()) {
+            auto pct = [&](double q) {
+                auto it = latency.begin() + static_cast<std::ptrdiff_t>(q * (latency.size() - 1));
+                std::nth_element(latency.begin(), it, latency.end());
+                return *it;
+            };
+            st.p50Ns = pct(0.50);
+            st.p99Ns = pct(0.99);
+        }
+        return st;
+    }
+
+    // Баланс после обработки (для сверки); -1 - счёта нет
+    int64_t balance(std::string_view number) {
+        AccountNumber key;
+        if (!AccountNumber::make(number, key)) return -1;
+        AccountRecord* r = shards_[shardOf(key)]->accounts.find(key);
+        return r ? r->kopecks : -1;
+    }
+
+private:
+    struct Shard {
+        AccountRegistry accounts;
+        std::mutex mu;
+        std::condition_variable ready, space;
+        std::vector<BatchOp> queue;
+        std::vector<BatchOp> credits;   // зачисления из других шардов
+        bool inputDone = false;
+        uint64_t creditsTotal = 0;      // известно к inputDone
+        std::string out;
+        std::vector<int64_t> latency;
+        size_t ok = 0, rejected = 0;
+    };
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    size_t shardOf(const AccountNumber& a) const { return a.hash() % shards_.size(); }
+
+    // Перевод, за которым шард получателя ждёт зачисление (пустое при отказе)
+    bool crossShard(const BatchOp& op) const {
+        return op.type == BatchOpType::Transfer && op.targetOpen && shardOf(op.target) != shardOf(op.account);
+    }
+
+    static const char* parse(const CsvRow& row, BatchOp& op) {
+        static const std::pair<std::string_view, BatchOpType> kOps[] = {
+            {"OPEN", BatchOpType::Open},     {"DEPOSIT", BatchOpType::Deposit}, {"WITHDRAW", BatchOpType::Withdraw},
+            {"TRANSFER", BatchOpType::Transfer}, {"ACCRUE", BatchOpType::Accrue}, {"RATE", BatchOpType::Rate}};
+        auto it = std::find_if(std::begin(kOps), std::end(kOps), [&](const auto& p) { return p.first == row[0]; });
+        if (it == std::end(kOps)) return "неизвестная операция";
+        op.type = it->second;
+        static const size_t kFields[] = {4, 3, 3, 4, 2, 3};
+        if (row.size() < kFields[static_cast<int>(op.type)]) return "не хватает полей";
+        if (!AccountNumber::make(row[1], op.account)) return "некорректный номер счета";
+        double v = 0;
+        if (op.type != BatchOpType::Accrue && !parseDouble(row[2], v)) return "некорректное число";
+        switch (op.type) {
+            case BatchOpType::Open:
+                op.amount = toKopecks(v);
+                op.owner = row[3];
+                if (row.size() > 4) {
+                    double rate;
+                    if (!parseDouble(row[4], rate)) return "некорректная ставка";
+                    op.savings = true;
+                    op.ratePpm = toRatePpm(rate);
+                }
+                break;
+            case BatchOpType::Rate: op.ratePpm = toRatePpm(v); break;
+            case BatchOpType::Transfer:
+                if (!AccountNumber::make(row[3], op.target)) return "некорректный номер получателя";
+                op.amount = toKopecks(v);
+                break;
+            default: op.amount = toKopecks(v); break;
+        }
+        return nullptr;
+    }
+
+    // Передаёт накопленные строки во все шарды сразу: зачисление, которого
+    // ждёт шард, всегда уже у отправителя. Читатель ждёт места в очереди;
+    // totals - конец файла и число зачислений по шардам
+    void pushAll(std::vector<std::vector<BatchOp>>& batches, const std::vector<uint64_t>* totals) {
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            Shard& sh = *shards_[i];
+            {
+                std::unique_lock<std::mutex> lock(sh.mu);
+                sh.space.wait(lock, [&] { return sh.queue.size() < kQueueLimit; });
+                sh.queue.insert(sh.queue.end(), batches[i].begin(), batches[i].end());
+                if (totals) {
+                    sh.inputDone = true;
+                    sh.creditsTotal = (*totals)[i];
+                }
+            }
+            sh.ready.notify_one();
+            batches[i].clear();
+        }
+    }
+
+    void sendCredits(size_t d, std::vector<BatchOp>& credits) {
+        if (credits.empty()) return;
+        Shard& sh = *shards_[d];
+        {
+            std::lock_guard<std::mutex> lock(sh.mu);
+            sh.credits.insert(sh.credits.end(), credits.begin(), credits.end());
+        }
+        sh.ready.notify_one();
+        credits.clear();
+    }
+
+    void sendCredits(std::vector<std::vector<BatchOp>>& outgoing) {
+        for (size_t d = 0; d < outgoing.size(); ++d) sendCredits(d, outgoing[d]);
+    }
+
+    struct LaterCredit {
+        bool operator()(const BatchOp& a, const BatchOp& b) const { return a.creditSeq > b.creditSeq; }
+    };
+
+    void work(size_t index) {
+        Shard& s = *shards_[index];
+        std::vector<BatchOp> work;
+        std::vector<std::vector<BatchOp>> outgoing(shards_.size());
+        std::priority_queue<BatchOp, std::vector<BatchOp>, LaterCredit> credits;
+        uint64_t applied = 0;
+        // Зачисления строго по номерам, пока их не станет n; недостающие ждём
+        auto applyCredits = [&](uint64_t n) {
+            while (applied < n) {
+                if (!credits.empty() && credits.top().creditSeq == applied) {
+                    execute(s, credits.top(), outgoing);
+                    credits.pop();
+                    ++applied;
+                    continue;
+                }
+                sendCredits(outgoing); // отправитель недостающего может ждать наших
+                std::unique_lock<std::mutex> lock(s.mu);
+                s.ready.wait(lock, [&] { return !s.credits.empty(); });
+                for (const BatchOp& c : s.credits) credits.push(c);
+                s.credits.clear();
+            }
+        };
+        bool last = false;
+        uint64_t total = 0;
+        while (!last) {
+            {
+                std::unique_lock<std::mutex> lock(s.mu);
+                s.ready.wait(lock, [&] { return !s.queue.empty() || s.inputDone; });
+                work.swap(s.queue);
+                last = s.inputDone;
+                total = s.creditsTotal;
+            }
+            s.space.notify_one();
+            for (size_t i = 0; i < work.size(); ++i) {
+                applyCredits(work[i].creditsBefore);
+                execute(s, work[i], outgoing);
+                if (i % kCreditFlush == kCreditFlush - 1) sendCredits(outgoing); // получатели могут ждать
+            }
+            work.clear();
+            sendCredits(outgoing);
+            flushOut(s, false);
+        }
+        applyCredits(total);
+        flushOut(s, true);
+    }
+
+    void execute(Shard& s, const BatchOp& op, std::vector<std::vector<BatchOp>>& outgoing) {
+        static const char* kNames[] = {"OPEN", "DEPOSIT", "WITHDRAW", "TRANSFER", "ACCRUE", "RATE", "TRANSFER"};
+        std::string_view name = kNames[static_cast<int>(op.type)];
+        std::string_view number = op.account.view();
+        AccountRecord* r = s.accounts.find(op.account);
+        if (op.type == BatchOpType::Open) {
+            r = s.accounts.add(op.account, op.owner, op.amount, op.savings ? AccountKind::Savings : AccountKind::Regular,
+                               op.ratePpm);
+            if (!r) return result(s, op, name, number, false, "счет уже существует");
+            if (op.amount < 0) r->kopecks = 0;
+            return result(s, op, name, number, true, r);
+        }
+        if (op.type == BatchOpType::Credit && op.amount == 0) return; // списание было отклонено
+        if (!r) return result(s, op, name, number, false, "счет не найден");
+        switch (op.type) {
+            case BatchOpType::Deposit:
+            case BatchOpType::Credit:
+                if (!r->deposit(op.amount)) return result(s, op, name, number, false, "сумма должна быть положительной");
+                break;
+            case BatchOpType::Withdraw:
+                if (op.amount <= 0) return result(s, op, name, number, false, "сумма должна быть положительной");
+                if (!r->withdraw(op.amount)) return result(s, op, name, number, false, "недостаточно средств на счете");
+                break;
+            case BatchOpType::Accrue:
+                if (r->kind != AccountKind::Savings) return result(s, op, name, number, false, "не сберегательный счет");
+                r->applyInterest();
+                break;
+            case BatchOpType::Rate:
+                if (r->kind != AccountKind::Savings) return result(s, op, name, number, false, "не сберегательный счет");
+                if (op.ratePpm < 0) return result(s, op, name, number, false, "ставка не может быть отрицательной");
+                r->ratePpm = op.ratePpm;
+                break;
+            case BatchOpType::Transfer: {
+                if (op.amount <= 0) return result(s, op, name, number, false, "сумма должна быть положительной");
+                if (!op.targetOpen) return result(s, op, name, op.target.view(), false, "счет получателя не найден");
+                if (op.account == op.target) return result(s, op, name, number, false, "перевод на тот же счет");
+                if (!r->withdraw(op.amount)) return result(s, op, name, number, false, "недостаточно средств на счете");
+                size_t dest = shardOf(op.target);
+                AccountRecord* to = &*shards_[dest] == &s ? s.accounts.find(op.target) : nullptr;
+                if (!to) {
+                    BatchOp credit = op;
+                    credit.type = BatchOpType::Credit;
+                    std::swap(credit.account, credit.target); // account - получатель, target - отправитель
+                    outgoing[dest].push_back(credit);
+                    return;
+                }
+                to->kopecks += op.amount;
+                return result(s, op, name, op.target.view(), true, to);
+            }
+            default: break;
+        }
+        return result(s, op, name, number, true, r);
+    }
+
+    // Строка результата; отклонённый перевод в другой шард шлёт пустое зачисление
+    void result(Shard& s, const BatchOp& op, std::string_view name, std::string_view number, bool ok, const char* reason) {
+        if (!ok && crossShard(op)) {
+            BatchOp none = op;
+            none.type = BatchOpType::Credit;
+            none.amount = 0;
+            std::swap(none.account, none.target);
+            std::vector<BatchOp> one{none};
+            sendCredits(shardOf(none.account), one);
+        }
+        write(s, op, name, number, ok, reason);
+    }
+
+    void result(Shard& s, const BatchOp& op, std::string_view name, std::string_view number, bool ok, const AccountRecord* r) {
+        char balance[32];
+        std::snprintf(balance, sizeof(balance), "%lld.%02lld", static_cast<long long>(r->kopecks / 100),
+                      static_cast<long long>(std::llabs(r->kopecks % 100)));
+        write(s, op, name, number, ok, balance);
+    }
+
+    void write(Shard& s, const BatchOp& op, std::string_view name, std::string_view number, bool ok, const char* detail) {
+        char head[48];
+        int n = std::snprintf(head, sizeof(head), "%llu,", static_cast<unsigned long long>(op.line));
+        s.out.append(head, static_cast<size_t>(n)).append(name).append(",").append(number);
+        s.out.append(ok ? ",OK," : ",REJECTED,").append(detail).append("\n");
+        ++(ok ? s.ok : s.rejected);
+        s.latency.push_back(nowNs() - op.startNs);
+    }
+
+    void flushOut(Shard& s, bool force) {
+        if (s.out.empty() || (!force && s.out.size() < kOutFlush)) return;
+        std::lock_guard<std::mutex> lock(outMu_);
+        out_.write(s.out.data(), static_cast<std::streamsize>(s.out.size()));
+        s.out.clear();
+    }
+
+    std::ostream& out_;
+    std::mutex outMu_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
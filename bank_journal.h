@@ -0,0 +1,498 @@
+#pragma once
+
+// Журнал операций (write-ahead log) и восстановление после сбоя.
+// Операция применяется к балансам и дописывается в журнал под одним
+// мьютексом (порядок в журнале = порядок применения), а ожидание
+// записи на диск идёт уже без него. Фоновый поток забирает всё
+// накопленное и делает один write + fdatasync на всю группу (group commit).
+// Запись: [crc32c][длина][тип][lsn][данные], CRC покрывает всё после себя.
+// Журнал разбит на сегменты wal-<первый lsn>.log. Контрольная точка пишет
+// снимок балансов (snapshot.bin, через rename) и удаляет старые сегменты.
+// Восстановление: снимок + записи сегментов с lsn больше, чем в снимке;
+// оборванный хвост (сбой посреди записи) отрезается по первой плохой CRC.
+
+#include "bank_accrual.h"
+#include "crc32c.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class JournalOp : uint8_t { Open = 1, Deposit, Withdraw, Interest, SetRate, AccrueAll };
+
+struct JournalRecord {
+    JournalOp op;
+    uint32_t account = 0;
+    int64_t amount = 0;    // копейки: начальный баланс, пополнение, снятие
+    int32_t ratePpm = 0;
+};
+
+struct JournalStats {
+    uint64_t records = 0;
+    uint64_t syncs = 0;      // вызовов fdatasync
+    uint64_t bytes = 0;
+};
+
+struct RecoveryStats {
+    uint64_t snapshotLsn = 0;
+    uint64_t lastLsn = 0;        // последняя восстановленная запись
+    uint64_t replayed = 0;
+    uint64_t truncatedBytes = 0; // отрезанный оборванный хвост
+    double seconds = 0;
+};
+
+// Дисковая часть: сегменты журнала, снимки, фоновая синхронизация
+class Journal {
+public:
+    ~Journal() { close(); }
+
+    // Восстанавливает store из dir (создаёт каталог при необходимости)
+    bool open(const std::string& dir, SavingsStore& store, RecoveryStats& rs) {
+        auto t0 = std::chrono::steady_clock::now();
+        dir_ = dir;
+        ::mkdir(dir.c_str(), 0755);
+        store = SavingsStore();
+        uint64_t lsn = 0;
+        if (!loadSnapshot(store, lsn)) return false;
+        rs.snapshotLsn = lsn;
+        for (uint64_t start : segments()) {
+            if (!replaySegment(start, store, lsn, rs)) return false;
+        }
+        rs.lastLsn = nextLsn_ = durableLsn_ = lsn;
+        ++nextLsn_;
+        failed_ = false;
+        if (!openSegment(nextLsn_)) return false;
+        stop_ = false;
+        flusher_ = std::thread([this] { flushLoop(); });
+        rs.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        return true;
+    }
+
+    void close() {
+        if (!flusher_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        flusher_.join();
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    // Дописывает запись в буфер группы; вызывать под внешним мьютексом
+    // применения, чтобы порядок lsn совпадал с порядком операций
+    uint64_t append(const JournalRecord& r) {
+        std::lock_guard<std::mutex> lock(mu_);
+        uint64_t lsn = nextLsn_++;
+        encode(r, lsn, pending_);
+        ++stats_.records;
+        wake_.notify_one();
+        return lsn;
+    }
+
+    // Ждёт, пока запись lsn не окажется на диске; false - ошибка записи
+    bool waitDurable(uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(mu_);
+        durable_.wait(lock, [&] { return durableLsn_ >= lsn || failed_; });
+        return durableLsn_ >= lsn;
+    }
+
+    // Контрольная точка: store - состояние ровно после lastLsn
+    bool checkpoint(const SavingsStore& store, uint64_t lastLsn) {
+        std::lock_guard<std::mutex> serial(checkpointMu_);
+        if (!waitDurable(lastLsn)) return false;
+        std::string tmp = dir_ + "/snapshot.tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        uint64_t n = store.size();
+        std::vector<int64_t> balances(n);
+        std::vector<int32_t> rates(n);
+        for (size_t i = 0; i < n; ++i) { balances[i] = store.balance(i); rates[i] = store.rate(i); }
+        uint32_t crc = crc32c(&lastLsn, sizeof(lastLsn));
+        crc = crc32c(&n, sizeof(n), crc);
+        crc = crc32c(balances.data(), n * sizeof(int64_t), crc);
+        crc = crc32c(rates.data(), n * sizeof(int32_t), crc);
+        bool ok = std::fwrite(kSnapshotMagic, sizeof(kSnapshotMagic), 1, f) == 1 &&
+                  std::fwrite(&crc, sizeof(crc), 1, f) == 1 && std::fwrite(&lastLsn, sizeof(lastLsn), 1, f) == 1 &&
+                  std::fwrite(&n, sizeof(n), 1, f) == 1 &&
+                  std::fwrite(balances.data(), sizeof(int64_t), n, f) == n &&
+                  std::fwrite(rates.data(), sizeof(int32_t), n, f) == n;
+        ok = std::fflush(f) == 0 && ok && syncFd(fileno(f));
+        ok = std::fclose(f) == 0 && ok;
+        if (!ok || std::rename(tmp.c_str(), (dir_ + "/snapshot.bin").c_str()) != 0) return false;
+        syncDir();
+        // Новый сегмент, затем удаляем сегменты, целиком покрытые снимком
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            rotate_ = true;
+            wake_.notify_one();
+            durable_.wait(lock, [&] { return !rotate_ || failed_; });
+            if (failed_) return false;
+        }
+        std::vector<uint64_t> segs = segments();
+        for (size_t i = 0; i + 1 < segs.size(); ++i)
+            if (segs[i + 1] <= lastLsn + 1) ::unlink(segmentPath(segs[i]).c_str());
+        return true;
+    }
+
+    JournalStats stats() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return stats_;
+    }
+
+    // Применение записи к балансам (и при работе, и при восстановлении)
+    static bool apply(const JournalRecord& r, SavingsStore& store) {
+        if (r.op == JournalOp::Open) { store.add(r.amount, r.ratePpm); return true; }
+        if (r.op == JournalOp::AccrueAll) { accrueInterest(store); return true; }
+        if (r.account >= store.size()) return false;
+        int64_t* b = store.balances() + r.account;
+        switch (r.op) {
+            case JournalOp::Deposit: *b += r.amount; return true;
+            case JournalOp::Withdraw:
+                if (*b < r.amount) return false;
+                *b -= r.amount;
+                return true;
+            case JournalOp::Interest: *b += interestFor(*b, store.rate(r.account)); return true;
+            case JournalOp::SetRate: store.setRate(r.account, r.ratePpm); return true;
+            default: return false;
+        }
+    }
+
+private:
+    static constexpr char kSnapshotMagic[8] = {'B', 'A', 'N', 'K', 'S', 'N', 'P', '1'};
+    static constexpr size_t kHeader = 16; // crc(4) длина(2) тип(1) резерв(1) lsn(8)
+
+    static void put(std::string& out, const void* p, size_t n) { out.append(static_cast<const char*>(p), n); }
+
+    static void encode(const JournalRecord& r, uint64_t lsn, std::string& out) {
+        char payload[16];
+        uint16_t len = 0;
+        auto add = [&](const void* p, size_t n) { std::memcpy(payload + len, p, n); len += static_cast<uint16_t>(n); };
+        switch (r.op) {
+            case JournalOp::Open: add(&r.amount, 8); add(&r.ratePpm, 4); break;
+            case JournalOp::Deposit:
+            case JournalOp::Withdraw: add(&r.account, 4); add(&r.amount, 8); break;
+            case JournalOp::Interest: add(&r.account, 4); break;
+            case JournalOp::SetRate: add(&r.account, 4); add(&r.ratePpm, 4); break;
+            case JournalOp::AccrueAll: break;
+        }
+        size_t at = out.size();
+        uint32_t crc = 0;
+        uint8_t type = static_cast<uint8_t>(r.op), reserved = 0;
+        put(out, &crc, 4);
+        put(out, &len, 2);
+        put(out, &type, 1);
+        put(out, &reserved, 1);
+        put(out, &lsn, 8);
+        put(out, payload, len);
+        crc = crc32c(out.data() + at + 4, kHeader - 4 + len);
+        std::memcpy(&out[at], &crc, 4);
+    }
+
+    // Разбор записи; 0 - запись повреждена или оборвана, иначе её длина
+    static size_t decode(const char* p, size_t avail, JournalRecord& r, uint64_t& lsn) {
+        if (avail < kHeader) return 0;
+        uint32_t crc;
+        uint16_t len;
+        std::memcpy(&crc, p, 4);
+        std::memcpy(&len, p + 4, 2);
+        if (len > 16 || avail < kHeader + len || crc32c(p + 4, kHeader - 4 + len) != crc) return 0;
+        r = JournalRecord{static_cast<JournalOp>(static_cast<uint8_t>(p[6]))};
+        std::memcpy(&lsn, p + 8, 8);
+        const char* d = p + kHeader;
+        switch (r.op) {
+            case JournalOp::Open: std::memcpy(&r.amount, d, 8); std::memcpy(&r.ratePpm, d + 8, 4); break;
+            case JournalOp::Deposit:
+            case JournalOp::Withdraw: std::memcpy(&r.account, d, 4); std::memcpy(&r.amount, d + 4, 8); break;
+            case JournalOp::Interest: std::memcpy(&r.account, d, 4); break;
+            case JournalOp::SetRate: std::memcpy(&r.account, d, 4); std::memcpy(&r.ratePpm, d + 4, 4); break;
+            case JournalOp::AccrueAll: break;
+            default: return 0;
+        }
+        return kHeader + len;
+    }
+
+    static bool syncFd(int fd) {
+#if defined(__APPLE__)
+        return fcntl(fd, F_FULLFSYNC) == 0 || fsync(fd) == 0; // fsync на macOS не сбрасывает кэш диска
+#else
+        return fdatasync(fd) == 0;
+#endif
+    }
+
+    void syncDir() {
+        int fd = ::open(dir_.c_str(), O_RDONLY);
+        if (fd >= 0) { fsync(fd); ::close(fd); }
+    }
+
+    std::string segmentPath(uint64_t start) const {
+        char name[48];
+        std::snprintf(name, sizeof(name), "/wal-%020llu.log", static_cast<unsigned long long>(start));
+        return dir_ + name;
+    }
+
+    // Первые lsn сегментов по возрастанию
+    std::vector<uint64_t> segments() const {
+        std::vector<uint64_t> out;
+        if (DIR* d = opendir(dir_.c_str())) {
+            while (dirent* e = readdir(d)) {
+                unsigned long long start;
+                char tail[8];
+                if (std::sscanf(e->d_name, "wal-%llu.%4s", &start, tail) == 2 && !std::strcmp(tail, "log"))
+                    out.push_back(start);
+            }
+            closedir(d);
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    bool loadSnapshot(SavingsStore& store, uint64_t& lsn) {
+        FILE* f = std::fopen((dir_ + "/snapshot.bin").c_str(), "rb");
+        if (!f) return true; // снимка ещё нет
+        char magic[8];
+        uint32_t crc;
+        uint64_t n = 0;
+        bool ok = std::fread(magic, 8, 1, f) == 1 && !std::memcmp(magic, kSnapshotMagic, 8) &&
+                  std::fread(&crc, 4, 1, f) == 1 && std::fread(&lsn, 8, 1, f) == 1 && std::fread(&n, 8, 1, f) == 1;
+        std::vector<int64_t> balances;
+        std::vector<int32_t> rates;
+        if (ok) {
+            balances.resize(n);
+            rates.resize(n);
+            ok = std::fread(balances.data(), sizeof(int64_t), n, f) == n &&
+                 std::fread(rates.data(), sizeof(int32_t), n, f) == n;
+        }
+        std::fclose(f);
+        if (ok) {
+            uint32_t c = crc32c(&lsn, sizeof(lsn));
+            c = crc32c(&n, sizeof(n), c);
+            c = crc32c(balances.data(), n * sizeof(int64_t), c);
+            ok = crc32c(rates.data(), n * sizeof(int32_t), c) == crc;
+        }
+        if (!ok) {
+            std::cerr << "Снимок " << dir_ << "/snapshot.bin поврежден" << std::endl;
+            return false;
+        }
+        store.reserve(n);
+        for (uint64_t i = 0; i < n; ++i) store.add(balances[i], rates[i]);
+        return true;
+    }
+
+    bool replaySegment(uint64_t start, SavingsStore& store, uint64_t& lsn, RecoveryStats& rs) {
+        std::string path = segmentPath(start);
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return false;
+        std::string data;
+        char buf[1 << 16];
+        for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) data.append(buf, n);
+        std::fclose(f);
+
+        size_t pos = 0;
+        JournalRecord r{JournalOp::Open};
+        uint64_t recLsn;
+        for (size_t n; (n = decode(data.data() + pos, data.size() - pos, r, recLsn)) > 0; pos += n) {
+            if (recLsn <= lsn) continue; // уже в снимке
+            if (recLsn != lsn + 1) {
+                std::cerr << "Журнал " << path << ": пропуск lsn " << lsn + 1 << std::endl;
+                return false;
+            }
+            apply(r, store);
+            lsn = recLsn;
+            ++rs.replayed;
+        }
+        if (pos < data.size()) {
+            // Оборванная запись в конце: отрезаем, чтобы дописывать следом
+            rs.truncatedBytes += data.size() - pos;
+            if (::truncate(path.c_str(), static_cast<off_t>(pos)) != 0) return false;
+        }
+        return true;
+    }
+
+    bool openSegment(uint64_t start) {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = ::open(segmentPath(start).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd_ < 0) {
+            std::cerr << "Не удалось открыть журнал: " << segmentPath(start) << std::endl;
+            return false;
+        }
+        syncDir();
+        return true;
+    }
+
+    void flushLoop() {
+        std::string batch;
+        for (;;) {
+            uint64_t upTo;
+            bool rotate;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                wake_.wait(lock, [&] { return stop_ || rotate_ || !pending_.empty(); });
+                if (pending_.empty() && !rotate_ && stop_) break;
+                batch.swap(pending_);
+                upTo = nextLsn_ - 1;
+                rotate = rotate_; // сбрасывается после открытия нового сегмента
+            }
+            bool ok = true;
+            for (size_t off = 0; ok && off < batch.size();) {
+                ssize_t n = ::write(fd_, batch.data() + off, batch.size() - off);
+                if (n < 0) ok = false;
+                else off += static_cast<size_t>(n);
+            }
+            if (ok && !batch.empty()) ok = syncFd(fd_);
+            if (ok && rotate) ok = openSegment(upTo + 1);
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                if (ok) {
+                    durableLsn_ = upTo;
+                    stats_.bytes += batch.size();
+                    if (!batch.empty()) ++stats_.syncs;
+                    if (rotate) rotate_ = false;
+                } else {
+                    failed_ = true;
+                    std::cerr << "Ошибка записи журнала" << std::endl;
+                }
+            }
+            durable_.notify_all();
+            batch.clear();
+            if (!ok) break;
+        }
+    }
+
+    std::string dir_;
+    int fd_ = -1;
+    std::mutex mu_, checkpointMu_;
+    std::condition_variable wake_, durable_;
+    std::string pending_;
+    uint64_t nextLsn_ = 1, durableLsn_ = 0;
+    bool stop_ = false, rotate_ = false, failed_ = false;
+    JournalStats stats_;
+    std::thread flusher_;
+};
+
+// Счета с журналом: операции безопасны из нескольких потоков и возвращают
+// управление только после того, как запись надёжно на диске. Чтение тоже
+// ждёт, пока все видимые им записи не окажутся на диске, поэтому наружу
+// попадает только зафиксированное состояние. После ошибки журнала счета
+// "испорчены": в памяти могут быть операции, которых нет на диске, и все
+// операции и чтения возвращают ошибку до повторного open.
+class DurableBank {
+public:
+    bool open(const std::string& dir, RecoveryStats& rs) {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!journal_.open(dir, store_, rs)) return false;
+        last_ = rs.lastLsn;
+        broken_ = false;
+        return true;
+    }
+    void close() { journal_.close(); }
+
+    // Номер нового счёта; -1 - ошибка журнала
+    int64_t openAccount(int64_t kopecks, int32_t ratePpm) { return openAccounts(1, kopecks, ratePpm); }
+
+    // count одинаковых счетов одной группой; номер первого или -1
+    int64_t openAccounts(size_t count, int64_t kopecks, int32_t ratePpm) {
+        uint64_t lsn = 0;
+        size_t first;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (broken_) return -1;
+            first = store_.size();
+            store_.reserve(first + count);
+            JournalRecord r{JournalOp::Open, 0, kopecks, ratePpm};
+            for (size_t i = 0; i < count; ++i) {
+                Journal::apply(r, store_);
+                lsn = last_ = journal_.append(r);
+            }
+        }
+        return settle(lsn) ? static_cast<int64_t>(first) : -1;
+    }
+
+    bool deposit(uint32_t account, int64_t kopecks) {
+        return kopecks > 0 && run({JournalOp::Deposit, account, kopecks});
+    }
+    bool withdraw(uint32_t account, int64_t kopecks) {
+        return kopecks > 0 && run({JournalOp::Withdraw, account, kopecks});
+    }
+    bool applyInterest(uint32_t account) { return run({JournalOp::Interest, account}); }
+    bool setInterestRate(uint32_t account, int32_t ratePpm) {
+        return ratePpm >= 0 && run({JournalOp::SetRate, account, 0, ratePpm});
+    }
+    bool accrueAll() { return run({JournalOp::AccrueAll}); }
+
+    bool checkpoint() {
+        SavingsStore copy;
+        uint64_t lsn = 0;
+        return readCommitted([&] { copy = store_; }, &lsn) && journal_.checkpoint(copy, lsn);
+    }
+
+    // false - счёта нет или ошибка журнала
+    bool balance(uint32_t account, int64_t& kopecks) {
+        bool found = false;
+        return readCommitted([&] {
+            found = account < store_.size();
+            if (found) kopecks = store_.balance(account);
+        }) && found;
+    }
+
+    // Копия зафиксированного состояния (для сверки после восстановления)
+    bool state(SavingsStore& out) {
+        return readCommitted([&] { out = store_; });
+    }
+
+    JournalStats stats() { return journal_.stats(); }
+
+private:
+    // Проверить и применить, затем записать; отклонённая операция в журнал не попадает
+    bool run(const JournalRecord& r) {
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (broken_ || !Journal::apply(r, store_)) return false;
+            lsn = last_ = journal_.append(r);
+        }
+        return settle(lsn);
+    }
+
+    // read() под замком видит состояние после записи last_; true - она уже на диске
+    template <class Read>
+    bool readCommitted(Read&& read, uint64_t* lsnOut = nullptr) {
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (broken_) return false;
+            read();
+            lsn = last_;
+        }
+        if (lsnOut) *lsnOut = lsn;
+        return settle(lsn);
+    }
+
+    // Ждёт, пока запись lsn не окажется на диске; ошибка журнала портит счета
+    bool settle(uint64_t lsn) {
+        if (journal_.waitDurable(lsn)) return true;
+        std::lock_guard<std::mutex> lock(mu_);
+        broken_ = true;
+        return false;
+    }
+
+    std::mutex mu_;
+    SavingsStore store_;
+    Journal journal_;
+    uint64_t last_ = 0;
+    bool broken_ = false;  // журнал отказал: store_ может быть впереди диска
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+// Конкурентный журнал балансов для BankAccount.
+// Баланс - целое число копеек в атомике, выровненном по кэш-линии (нет
+// ложного разделения между соседними счетами). Снятие - цикл CAS
+// "снять, если хватает". Перевод без блокировок: CAS-снятие с источника,
+// затем атомарное зачисление получателю - взаимоблокировки невозможны,
+// деньги не создаются и не теряются (сумма точна в состоянии покоя).
+// Журнал операций пишется фоновым потоком: рабочий поток только
+// складывает события в свой буфер и отдаёт его целиком раз в kBatch событий;
+// если фоновый поток отстал на kMaxPending буферов, рабочий поток ждёт.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+constexpr size_t kCacheLine = 64;
+
+struct alignas(kCacheLine) AccountCell {
+    std::atomic<int64_t> kopecks{0};
+};
+
+// Рубли (double) <-> копейки с округлением до ближайшей
+inline int64_t toKopecks(double rubles) {
+    return static_cast<int64_t>(rubles * 100 + (rubles < 0 ? -0.5 : 0.5));
+}
+inline double toRubles(int64_t kopecks) { return kopecks / 100.0; }
+
+class Ledger {
+public:
+    explicit Ledger(size_t accounts, int64_t initialKopecks = 0)
+        : cells_(new AccountCell[accounts]), size_(accounts) {
+        for (size_t i = 0; i < accounts; ++i) cells_[i].kopecks.store(initialKopecks, std::memory_order_relaxed);
+    }
+
+    size_t size() const { return size_; }
+
+    bool deposit(size_t account, int64_t amount) {
+        if (amount <= 0) return false;
+        cells_[account].kopecks.fetch_add(amount, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Снятие, только если хватает средств
+    bool withdraw(size_t account, int64_t amount) {
+        if (amount <= 0) return false;
+        std::atomic<int64_t>& cell = cells_[account].kopecks;
+        int64_t cur = cell.load(std::memory_order_relaxed);
+        while (cur >= amount) {
+            if (cell.compare_exchange_weak(cur, cur - amount, std::memory_order_acq_rel, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    bool transfer(size_t from, size_t to, int64_t amount) {
+        if (from == to || !withdraw(from, amount)) return false;
+        cells_[to].kopecks.fetch_add(amount, std::memory_order_acq_rel);
+        return true;
+    }
+
+    int64_t balance(size_t account) const { return cells_[account].kopecks.load(std::memory_order_acquire); }
+
+    // Сумма по всем счетам; точна, когда нет операций в полёте
+    int64_t total() const {
+        int64_t sum = 0;
+        for (size_t i = 0; i < size_; ++i) sum += balance(i);
+        return sum;
+    }
+
+private:
+    std::unique_ptr<AccountCell[]> cells_;
+    size_t size_;
+};
+
+enum class LedgerOp : uint8_t { Deposit, Withdraw, Transfer };
+
+struct LedgerEvent {
+    LedgerOp op;
+    bool ok;
+    uint32_t from, to;
+    int64_t amount;
+};
+
+// Фоновый журнал операций. Каждый рабочий поток пишет через свой Writer.
+class LedgerLog {
+public:
+    static constexpr size_t kBatch = 4096;
+    static constexpr size_t kMaxPending = 64;
+
+    explicit LedgerLog(std::ostream& out) : out_(out), thread_([this] { run(); }) {}
+
+    ~LedgerLog() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    class Writer {
+    public:
+        explicit Writer(LedgerLog& log) : log_(log) { buf_.reserve(kBatch); }
+        ~Writer() { flush(); }
+
+        void record(LedgerOp op, bool ok, size_t from, size_t to, int64_t amount) {
+            buf_.push_back({op, ok, static_cast<uint32_t>(from), static_cast<uint32_t>(to), amount});
+            if (buf_.size() >= kBatch) flush();
+        }
+
+        void flush() {
+            if (buf_.empty()) return;
+            log_.submit(std::move(buf_));
+            buf_ = {};
+            buf_.reserve(kBatch);
+        }
+
+    private:
+        LedgerLog& log_;
+        std::vector<LedgerEvent> buf_;
+    };
+
+    size_t written() const { return written_.load(std::memory_order_relaxed); }
+
+private:
+    void submit(std::vector<LedgerEvent>&& batch) {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            space_.wait(lock, [&] { return pending_.size() < kMaxPending; });
+            pending_.push_back(std::move(batch));
+        }
+        cv_.notify_one();
+    }
+
+    void run() {
+        static const char* kNames[] = {"DEPOSIT", "WITHDRAW", "TRANSFER"};
+        std::vector<std::vector<LedgerEvent>> work;
+        char line[96];
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [&] { return stop_ || !pending_.empty(); });
+                if (pending_.empty() && stop_) break;
+                work.swap(pending_);
+            }
+            space_.notify_all();
+            for (const auto& batch : work) {
+                for (const LedgerEvent& e : batch) {
+                    int n = std::snprintf(line, sizeof(line), "%s %u %u %lld.%02lld %s\n",
+                                          kNames[static_cast<int>(e.op)], e.from, e.to,
+                                          static_cast<long long>(e.amount / 100),
+                                          static_cast<long long>(e.amount % 100), e.ok ? "OK" : "REJECTED");
+                    out_.write(line, n);
+                }
+                written_.fetch_add(batch.size(), std::memory_order_relaxed);
+            }
+            work.clear();
+        }
+        out_.flush();
+    }
+
+    std::ostream& out_;
+    std::mutex mu_;
+    std::condition_variable cv_, space_;
+    std::vector<std::vector<LedgerEvent>> pending_;
+    std::atomic<size_t> written_{0};
+    bool stop_ = false;
+    std::thread thread_;
+};
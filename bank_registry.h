@@ -0,0 +1,186 @@
+#pragma once
+
+// Реестр счетов с поиском по номеру счета за O(1).
+// Номер хранится прямо в записи (до kAccountNumberLen символов, хвост
+// нулями), поэтому сравнение - три 8-байтовых слова, без std::string.
+// Записи лежат в арене блоками по kChunk штук: адреса не меняются при
+// росте, на каждый счёт нет отдельного new. Имена владельцев интернированы
+// (одно имя - одна копия в общем буфере), в записи только их номер.
+// Индекс - открытая адресация с линейным пробированием: слот 8 байт
+// (часть хеша + номер записи), заполнение не выше 1/2; поиск обычно стоит
+// одного промаха кэша по индексу и одного по записи.
+
+#include "bank_accrual.h"
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr size_t kAccountNumberLen = 24;
+
+struct AccountNumber {
+    uint64_t words[kAccountNumberLen / 8] = {};
+
+    // false - номер пустой или длиннее kAccountNumberLen
+    static bool make(std::string_view s, AccountNumber& out) {
+        if (s.empty() || s.size() > kAccountNumberLen) return false;
+        out = AccountNumber();
+        std::memcpy(out.words, s.data(), s.size());
+        return true;
+    }
+
+    std::string_view view() const {
+        const char* p = reinterpret_cast<const char*>(words);
+        return std::string_view(p, strnlen(p, kAccountNumberLen));
+    }
+
+    bool operator==(const AccountNumber& o) const {
+        return ((words[0] ^ o.words[0]) | (words[1] ^ o.words[1]) | (words[2] ^ o.words[2])) == 0;
+    }
+
+    // Цифры номера различаются в старших байтах слов - нужен полный перемес (fmix64)
+    uint64_t hash() const {
+        uint64_t h = words[0] ^ (words[1] * 0x9E3779B97F4A7C15ull) ^ (words[2] * 0xC2B2AE3D27D4EB4Full);
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        return h ^ (h >> 33);
+    }
+};
+
+enum class AccountKind : uint8_t { Regular, Savings };
+
+struct AccountRecord {
+    AccountNumber number;
+    int64_t kopecks = 0;
+    int32_t ratePpm = 0;   // только для Savings
+    uint32_t owner = 0;    // номер имени в StringPool
+    AccountKind kind = AccountKind::Regular;
+
+    bool deposit(int64_t amount) {
+        if (amount <= 0) return false;
+        kopecks += amount;
+        return true;
+    }
+
+    bool withdraw(int64_t amount) {
+        if (amount <= 0 || amount > kopecks) return false;
+        kopecks -= amount;
+        return true;
+    }
+
+    int64_t applyInterest() {
+        if (kind != AccountKind::Savings) return 0;
+        int64_t interest = interestFor(kopecks, ratePpm);
+        kopecks += interest;
+        return interest;
+    }
+};
+
+struct RegistryMemory {
+    size_t records = 0, index = 0, names = 0;
+    size_t total() const { return records + index + names; }
+};
+
+class AccountRegistry {
+public:
+    static constexpr size_t kChunk = 1 << 16;
+
+    // Готовит индекс и арену под n счетов (без перестроек при загрузке)
+    void reserve(size_t n) {
+        size_t want = 1024;
+        while (want < n * 2) want <<= 1;
+        if (want > slots_.size()) rehash(want);
+        while (chunks_.size() * kChunk < n) chunks_.emplace_back(new AccountRecord[kChunk]);
+    }
+
+    // nullptr - номер некорректен или уже занят
+    AccountRecord* add(std::string_view number, std::string_view owner, int64_t kopecks,
+                       AccountKind kind = AccountKind::Regular, int32_t ratePpm = 0) {
+        AccountNumber key;
+        return AccountNumber::make(number, key) ? add(key, owner, kopecks, kind, ratePpm) : nullptr;
+    }
+
+    AccountRecord* add(const AccountNumber& key, std::string_view owner, int64_t kopecks,
+                       AccountKind kind = AccountKind::Regular, int32_t ratePpm = 0) {
+        if ((size_ + 1) * 2 > slots_.size()) rehash(std::max<size_t>(slots_.size() * 2, 1024));
+        uint64_t h = key.hash();
+        size_t i = probe(key, h);
+        if (slots_[i].index != kEmpty) return nullptr;
+        if (size_ == chunks_.size() * kChunk) chunks_.emplace_back(new AccountRecord[kChunk]);
+        AccountRecord& r = at(size_);
+        r.number = key;
+        r.kopecks = kopecks;
+        r.ratePpm = kind == AccountKind::Savings ? ratePpm : 0;
+        r.owner = names_.intern(owner);
+        r.kind = kind;
+        slots_[i] = {static_cast<uint32_t>(h >> 32), static_cast<uint32_t>(size_++)};
+        return &r;
+    }
+
+    AccountRecord* find(std::string_view number) {
+        AccountNumber key;
+        return AccountNumber::make(number, key) ? find(key) : nullptr;
+    }
+
+    AccountRecord* find(const AccountNumber& key) {
+        size_t i = probe(key, key.hash());
+        return slots_.empty() || slots_[i].index == kEmpty ? nullptr : &at(slots_[i].index);
+    }
+
+    AccountRecord& at(size_t i) { return chunks_[i / kChunk][i % kChunk]; }
+    const AccountRecord& at(size_t i) const { return chunks_[i / kChunk][i % kChunk]; }
+    std::string_view owner(const AccountRecord& r) const { return names_.name(r.owner); }
+    size_t size() const { return size_; }
+    size_t owners() const { return names_.count(); }
+
+    RegistryMemory memory() const {
+        RegistryMemory m;
+        m.records = chunks_.size() * kChunk * sizeof(AccountRecord);
+        m.index = slots_.capacity() * sizeof(Slot);
+        m.names = names_.bytes();
+        return m;
+    }
+
+private:
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    struct Slot {
+        uint32_t tag;   // старшие 32 бита хеша: сравниваем номер, только если совпали
+        uint32_t index;
+    };
+
+    // Слот с этим номером или первый пустой на его пути
+    size_t probe(const AccountNumber& key, uint64_t h) const {
+        if (slots_.empty()) return 0;
+        size_t mask = slots_.size() - 1;
+        uint32_t tag = static_cast<uint32_t>(h >> 32);
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            const Slot& s = slots_[i];
+            if (s.index == kEmpty || (s.tag == tag && at(s.index).number == key)) return i;
+        }
+    }
+
+    void rehash(size_t n) {
+        std::vector<Slot> slots(n, Slot{0, kEmpty});
+        size_t mask = n - 1;
+        for (size_t r = 0; r < size_; ++r) {
+            uint64_t h = at(r).number.hash();
+            size_t i = h & mask;
+            while (slots[i].index != kEmpty) i = (i + 1) & mask;
+            slots[i] = {static_cast<uint32_t>(h >> 32), static_cast<uint32_t>(r)};
+        }
+        slots_.swap(slots);
+    }
+
+    std::vector<std::unique_ptr<AccountRecord[]>> chunks_;
+    std::vector<Slot> slots_;
+    StringPool names_;
+    size_t size_ = 0;
+};
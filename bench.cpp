@@ -0,0 +1,315 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <ctime>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <libpq-fe.h>
+#include "bank_batch.h"
+#include "bank_registry.h"
+#include "csv_reader.h"
+#include "csv_source.h"
+#include "datagen.h"
+#include "date_util.h"
+#include "device_io.h"
+#include "pg_copy.h"
+
+// Набор бенчмарков по всем трём программам на синтетических данных (datagen.h):
+// разбор CSV продаж, загрузка в Postgres через COPY, фильтры и сортировки
+// каталога устройств, операции со счетами. Результаты - таблица и JSON
+// (--json FILE) для сравнения прогонов.
+
+struct BenchResult {
+    std::string name;
+    double value;
+    std::string unit;
+};
+
+struct BenchOptions {
+    size_t rows = 1000000;
+    uint64_t seed = 42;
+    int repeats = 5;
+    std::string dir = ".";
+    std::string json;
+    std::string conninfo;  // пусто - загрузка в Postgres не измеряется
+    std::string only = "parse,load,devices,bank";
+    bool keep = false;     // оставить сгенерированные файлы
+};
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); }
+
+// Медиана из repeats прогонов, мс
+template <class F>
+double medianMs(int repeats, F&& f) {
+    std::vector<double> ms;
+    for (int i = 0; i < repeats; ++i) {
+        auto t0 = Clock::now();
+        f();
+        ms.push_back(secondsSince(t0) * 1000);
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+}
+
+bool wanted(const BenchOptions& opt, const char* section) {
+    std::string list = "," + opt.only + ",";
+    return list.find(std::string(",") + section + ",") != std::string::npos;
+}
+
+// Проход по sales.csv с разбором всех полей; fn получает каждую строку
+template <class Fn>
+size_t scanSales(const std::string& path, Fn fn) {
+    CsvSource reader;
+    if (!reader.open(path)) return 0;
+    CsvRow row;
+    reader.next(row); // header
+    size_t rows = 0;
+    int id, product, customer, quantity;
+    int32_t day;
+    double amount;
+    while (reader.next(row)) {
+        if (row.size() < 6 || !parseInt(row[0], id) || !parseDate(row[1], day) || !parseInt(row[2], product) ||
+            !parseInt(row[3], customer) || !parseInt(row[4], quantity) || !parseDouble(row[5], amount))
+            continue;
+        fn(id, day, product, customer, quantity, amount);
+        ++rows;
+    }
+    return rows;
+}
+
+// Сжатая копия файла для замера разбора .csv.gz (уровень 1: замеряется распаковка, а не сжатие)
+bool gzipFile(const std::string& from, const std::string& to) {
+    MappedFile in(from);
+    gzFile out = gzopen(to.c_str(), "wb1");
+    if (!in.isOpen() || !out) {
+        if (out) gzclose(out);
+        return false;
+    }
+    bool ok = true;
+    for (size_t at = 0; at < in.size() && ok; at += 1 << 20) {
+        unsigned n = static_cast<unsigned>(std::min<size_t>(in.size() - at, 1 << 20));
+        ok = gzwrite(out, in.data() + at, n) == static_cast<int>(n);
+    }
+    return gzclose(out) == Z_OK && ok;
+}
+
+void benchParse(const BenchOptions& opt, std::vector<BenchResult>& out) {
+    std::string path = opt.dir + "/sales.csv";
+    MappedFile f(path);
+    double mb = f.size() / 1e6;
+    size_t rows = 0;
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < std::min(opt.repeats, 3); ++i) {
+        auto t0 = Clock::now();
+        rows = scanSales(path, [](int, int32_t, int, int, int, double) {});
+        best = std::min(best, secondsSince(t0));
+    }
+    out.push_back({"parse.sales.rows_per_sec", rows / best, "rows/s"});
+    out.push_back({"parse.sales.mb_per_sec", mb / best, "MB/s"});
+
+    // Тот же файл в gzip: распаковка в своём потоке, разбор параллельно с ней
+    std::string gz = path + ".gz";
+    if (!gzipFile(path, gz)) {
+        std::cerr << "Cannot write " << gz << std::endl;
+        return;
+    }
+    best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < std::min(opt.repeats, 3); ++i) {
+        auto t0 = Clock::now();
+        rows = scanSales(gz, [](int, int32_t, int, int, int, double) {});
+        best = std::min(best, secondsSince(t0));
+    }
+    out.push_back({"parse.sales_gz.rows_per_sec", rows / best, "rows/s"});
+    out.push_back({"parse.sales_gz.mb_per_sec", mb / best, "MB/s"});
+    if (!opt.keep) std::remove(gz.c_str());
+}
+
+void benchLoad(const BenchOptions& opt, std::vector<BenchResult>& out) {
+    PGconn* conn = PQconnectdb(opt.conninfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::cerr << "Connection failed: " << PQerrorMessage(conn) << std::endl;
+        PQfinish(conn);
+        return;
+    }
+    PGresult* res = PQexec(conn, "CREATE TEMP TABLE bench_sales (sale_id INT, sale_date DATE, product_id INT, "
+                                 "customer_id INT, quantity INT, amount DECIMAL(10,2))");
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    PQclear(res);
+    for (CopyFormat format : {CopyFormat::Text, CopyFormat::Binary}) {
+        if (!ok) break;
+        PQclear(PQexec(conn, "TRUNCATE bench_sales"));
+        CopyOptions copy;
+        copy.format = format;
+        copy.skipDuplicates = false;
+        BulkLoader loader(conn, "bench_sales", "sale_id, sale_date, product_id, customer_id, quantity, amount", copy);
+        scanSales(opt.dir + "/sales.csv", [&](int id, int32_t day, int product, int customer, int quantity, double amount) {
+            CopyStream& row = loader.beginRow();
+            row.putInt(id);
+            row.putDate(day);
+            row.putInt(product);
+            row.putInt(customer);
+            row.putInt(quantity);
+            row.putNumeric(amount);
+            loader.endRow();
+        });
+        const LoadStats& st = loader.finish();
+        ok = st.failed == 0;
+        out.push_back({format == CopyFormat::Text ? "load.copy_text.rows_per_sec" : "load.copy_binary.rows_per_sec",
+                       st.rowsPerSec(), "rows/s"});
+    }
+    PQfinish(conn);
+}
+
+void benchDevices(const BenchOptions& opt, std::vector<BenchResult>& out) {
+    std::string path = opt.dir + "/devices.txt";
+    DeviceCatalog catalog;
+    auto t0 = Clock::now();
+    loadCatalogText(path, catalog);
+    out.push_back({"devices.load_text.ms", secondsSince(t0) * 1000, "ms"});
+    out.push_back({"devices.count", double(catalog.size()), "devices"});
+
+    std::string saved = opt.dir + "/devices_saved.txt";
+    out.push_back({"devices.save_text.ms", medianMs(1, [&] { saveCatalogText(saved, catalog); }), "ms"});
+    std::remove(saved.c_str());
+
+    std::vector<DeviceId> found;
+    DeviceIndex& index = catalog.index();
+    out.push_back({"devices.filter_price.ms", medianMs(opt.repeats, [&] {
+        found.clear();
+        index.price().forRange(2500, std::numeric_limits<double>::infinity(), [&](DeviceId id) { found.push_back(id); });
+    }), "ms"});
+    out.push_back({"devices.filter_brand_os_app.ms", medianMs(opt.repeats, [&] {
+        IdBitmap ids = IdBitmap::intersect(index.byBrand(catalog.brands().find("Apple")),
+                                           index.byOs(catalog.oses().find("iOS")));
+        found = IdBitmap::intersect(ids, index.byApp(catalog.appNames().find("Zoom"))).toVector();
+    }), "ms"});
+    out.push_back({"devices.sort_price.ms", medianMs(opt.repeats, [&] { catalog.sortByPrice(); }), "ms"});
+    out.push_back({"devices.sort_brand_price.first.ms", medianMs(1, [&] { catalog.sortByBrandPrice(); }), "ms"});
+    out.push_back({"devices.sort_brand_price.ms", medianMs(opt.repeats, [&] { catalog.sortByBrandPrice(); }), "ms"});
+    std::mt19937_64 rng(opt.seed);
+    out.push_back({"devices.edit_and_resort.ms", medianMs(opt.repeats, [&] {
+        const std::vector<DeviceId>& order = catalog.order();
+        catalog.setPrice(order[rng() % order.size()], 100 + double(rng() % 290000) / 100);
+        catalog.sortByBrandPrice();
+    }), "ms"});
+    out.push_back({"devices.search_index.ms", medianMs(1, [&] { catalog.syncSearch(); }), "ms"});
+    std::vector<SearchHit> hits;
+    out.push_back({"devices.search_prefix.ms", medianMs(opt.repeats, [&] { hits = catalog.search("model-4242", 20); }), "ms"});
+    out.push_back({"devices.search_fuzzy.ms", medianMs(opt.repeats, [&] { hits = catalog.search("modle-42424", 20); }), "ms"});
+}
+
+void benchBank(const BenchOptions& opt, std::vector<BenchResult>& out) {
+    size_t accounts = std::max<size_t>(opt.rows / 10, 1000);
+    std::vector<std::string> numbers(accounts);
+    for (size_t i = 0; i < accounts; ++i) numbers[i] = accountNumberFor(i);
+
+    AccountRegistry registry;
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < accounts; ++i) registry.add(numbers[i], "Client", 100000);
+    out.push_back({"bank.registry_add.ops_per_sec", accounts / secondsSince(t0), "ops/s"});
+
+    std::mt19937_64 rng(opt.seed);
+    std::vector<uint32_t> targets(opt.rows);
+    for (uint32_t& t : targets) t = static_cast<uint32_t>(rng() % accounts);
+    t0 = Clock::now();
+    for (uint32_t t : targets) registry.find(numbers[t])->deposit(100);
+    out.push_back({"bank.registry_deposit.ops_per_sec", targets.size() / secondsSince(t0), "ops/s"});
+
+    std::string ops = opt.dir + "/operations.csv", results = opt.dir + "/results.csv";
+    if (!generateBankOps(ops, accounts, opt.rows, opt.seed)) {
+        std::cerr << "Cannot write " << ops << std::endl;
+        return;
+    }
+    {
+        MappedFile in(ops);
+        std::ofstream sink(results, std::ios::binary);
+        BatchProcessor processor(sink);
+        BatchStats st = processor.run(in.view());
+        out.push_back({"bank.batch.ops_per_sec", st.ops / st.seconds, "ops/s"});
+        out.push_back({"bank.batch.p99_us", st.p99Ns / 1000.0, "us"});
+    }
+    if (!opt.keep) {
+        std::remove(ops.c_str());
+        std::remove(results.c_str());
+    }
+}
+
+bool writeJson(const std::string& path, const BenchOptions& opt, const std::vector<BenchResult>& results) {
+    std::ofstream f(path);
+    if (!f) return false;
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    f << "{\n  \"timestamp\": \"" << stamp << "\",\n  \"rows\": " << opt.rows << ",\n  \"seed\": " << opt.seed
+      << ",\n  \"repeats\": " << opt.repeats << ",\n  \"threads\": " << std::thread::hardware_concurrency()
+      << ",\n  \"results\": {\n";
+    f << std::setprecision(10);
+    for (size_t i = 0; i < results.size(); ++i) {
+        f << "    \"" << results[i].name << "\": {\"value\": " << results[i].value << ", \"unit\": \""
+          << results[i].unit << "\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    f << "  }\n}\n";
+    return bool(f);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--rows") && i + 1 < argc) opt.rows = parseCount(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) opt.seed = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "--repeats") && i + 1 < argc) opt.repeats = std::max(1, std::stoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--dir") && i + 1 < argc) opt.dir = argv[++i];
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc) opt.json = argv[++i];
+        else if (!std::strcmp(argv[i], "--pg") && i + 1 < argc) opt.conninfo = argv[++i];
+        else if (!std::strcmp(argv[i], "--only") && i + 1 < argc) opt.only = argv[++i];
+        else if (!std::strcmp(argv[i], "--keep")) opt.keep = true;
+        else {
+            std::cerr << "Usage: bench [--rows N[K|M]] [--seed S] [--repeats R] [--dir DIR] [--json FILE]\n"
+                         "             [--pg CONNINFO] [--only parse,load,devices,bank] [--keep]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    bool sales = wanted(opt, "parse") || (wanted(opt, "load") && !opt.conninfo.empty());
+    if (sales && !generateSalesCsv(opt.dir, SalesSize::forSales(opt.rows), opt.seed)) {
+        std::cerr << "Cannot write sales data to " << opt.dir << std::endl;
+        return 1;
+    }
+    if (wanted(opt, "parse")) benchParse(opt, results);
+    if (wanted(opt, "load") && !opt.conninfo.empty()) benchLoad(opt, results);
+    if (wanted(opt, "devices")) {
+        if (!generateDevicesText(opt.dir + "/devices.txt", opt.rows, opt.seed)) {
+            std::cerr << "Cannot write devices to " << opt.dir << std::endl;
+            return 1;
+        }
+        benchDevices(opt, results);
+        if (!opt.keep) std::remove((opt.dir + "/devices.txt").c_str());
+    }
+    if (wanted(opt, "bank")) benchBank(opt, results);
+    if (sales && !opt.keep)
+        for (const char* f : {"/products.csv", "/customers.csv", "/sales.csv"}) std::remove((opt.dir + f).c_str());
+
+    std::cout << "\n⏱  Benchmarks, " << opt.rows << " rows, seed " << opt.seed << ":\n";
+    for (const BenchResult& r : results) {
+        std::cout << std::left << std::setw(36) << r.name << std::right << std::setw(16) << std::fixed
+                  << std::setprecision(r.value < 100 ? 3 : 0) << r.value << " " << r.unit << std::endl;
+    }
+    if (!opt.json.empty()) {
+        if (!writeJson(opt.json, opt, results)) {
+            std::cerr << "Cannot write " << opt.json << std::endl;
+            return 1;
+        }
+        std::cout << "📄 Results -> " << opt.json << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// CRC32C (Castagnoli): аппаратная инструкция, если есть (SSE4.2 / ARMv8 CRC),
+// иначе программно, таблицами по 8 байт за шаг.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+struct Crc32cTables {
+    uint32_t t[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+            for (int k = 1; k < 8; ++k) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    }
+};
+
+inline const Crc32cTables& crc32cTables() {
+    static const Crc32cTables t;
+    return t;
+}
+
+// crc - результат предыдущего вызова (для данных по частям), 0 - начало
+inline uint32_t crc32c(const void* data, size_t n, uint32_t crc = 0) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint32_t c = ~crc;
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    uint64_t c64 = c;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+    }
+    c = static_cast<uint32_t>(c64);
+    for (; n; --n) c = _mm_crc32_u8(c, *p++);
+#elif defined(__ARM_FEATURE_CRC32)
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        c = __crc32cd(c, w);
+    }
+    for (; n; --n) c = __crc32cb(c, *p++);
+#else
+    const auto& t = crc32cTables().t;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= c; // порядок байт little-endian
+        c = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; n; --n) c = t[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+#endif
+    return ~c;
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+// CSV без копирования: файл отображается в память (mmap), разделители и
+// переводы строк ищутся блоками по 64 байта через SIMD (AVX2 / SSE2 / NEON,
+// иначе скалярно), поля отдаются как std::string_view.
+// Поддерживаются кавычки ("a, b" и "" внутри кавычек) и окончания строк CRLF.
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) { ::close(fd); size_ = 0; return false; }
+            data_ = static_cast<const char*>(p);
+            madvise(p, size_, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+        open_ = true;
+        return true;
+    }
+
+    void close() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+    // Отдать ядру страницы [0, offset): они уже прочитаны и больше не нужны
+    void release(size_t offset) {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t len = offset / page * page;
+        if (data_ && len) madvise(const_cast<char*>(data_), len, MADV_DONTNEED);
+    }
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+};
+
+// Одна запись CSV. Поля указывают либо в исходный буфер, либо (если в поле
+// были удвоенные кавычки) в scratch - до следующего вызова CsvReader::next.
+struct CsvRow {
+    std::vector<std::string_view> fields;
+    std::string scratch;
+
+    size_t size() const { return fields.size(); }
+    std::string_view operator[](size_t i) const { return fields[i]; }
+};
+
+class CsvReader {
+public:
+    CsvReader(const char* begin, const char* end, char delim = ',')
+        : begin_(begin), end_(end), cur_(begin), delim_(delim) {
+        loadBlock(begin);
+    }
+    explicit CsvReader(std::string_view data, char delim = ',')
+        : CsvReader(data.data(), data.data() + data.size(), delim) {}
+
+    // Читает следующую запись; false - данные кончились
+    bool next(CsvRow& row) {
+        row.fields.clear();
+        row.scratch.clear();
+        if (cur_ >= end_) return false;
+        while (true) {
+            const char* fieldStart = cur_;
+            if (cur_ < end_ && *cur_ == '"') {
+                if (!readQuoted(row)) return true;
+            } else {
+                const char* p = nextStructural(cur_);
+                while (p < end_ && *p == '"') p = nextStructural(p + 1);
+                std::string_view f(fieldStart, static_cast<size_t>(p - fieldStart));
+                cur_ = p;
+                if (p >= end_ || *p == '\n') {
+                    if (!f.empty() && f.back() == '\r') f.remove_suffix(1);
+                    row.fields.push_back(f);
+                    cur_ = p < end_ ? p + 1 : end_;
+                    return true;
+                }
+                row.fields.push_back(f);
+                cur_ = p + 1; // разделитель
+            }
+        }
+    }
+
+    // Смещение текущей позиции от начала буфера
+    size_t offset() const { return static_cast<size_t>(cur_ - begin_); }
+
+private:
+    // Поле в кавычках; cur_ указывает на открывающую кавычку.
+    // Возвращает false, если запись закончилась этим полем.
+    bool readQuoted(CsvRow& row) {
+        const char* start = cur_ + 1;
+        const char* p = start;
+        bool escaped = false;
+        while (true) {
+            p = nextStructural(p);
+            while (p < end_ && *p != '"') p = nextStructural(p + 1);
+            if (p + 1 < end_ && p[1] == '"') { escaped = true; p += 2; continue; }
+            break;
+        }
+        const char* close = p < end_ ? p : end_;
+        std::string_view f(start, static_cast<size_t>(close - start));
+        if (escaped) {
+            // Удвоенные кавычки разворачиваются в scratch; резерв под всю
+            // оставшуюся запись, чтобы ранее выданные view не инвалидировались
+            if (row.scratch.capacity() < row.scratch.size() + f.size())
+                relocateScratch(row, row.scratch.size() + f.size() + 64);
+            size_t at = row.scratch.size();
+            for (size_t i = 0; i < f.size(); ++i) {
+                row.scratch.push_back(f[i]);
+                if (f[i] == '"') ++i;
+            }
+            f = std::string_view(row.scratch.data() + at, row.scratch.size() - at);
+        }
+        row.fields.push_back(f);
+        // после закрывающей кавычки ожидаем разделитель или конец строки
+        p = close < end_ ? close + 1 : end_;
+        const char* q = nextStructural(p);
+        while (q < end_ && *q == '"') q = nextStructural(q + 1);
+        cur_ = q < end_ ? q + 1 : end_;
+        return !(q >= end_ || *q == '\n');
+    }
+
+    // При росте scratch пересчитать view, уже указывающие в него
+    static void relocateScratch(CsvRow& row, size_t cap) {
+        const char* oldBegin = row.scratch.data();
+        const char* oldEnd = oldBegin + row.scratch.size();
+        std::string fresh;
+        fresh.reserve(cap);
+        fresh.assign(row.scratch);
+        for (auto& f : row.fields)
+            if (f.data() >= oldBegin && f.data() < oldEnd)
+                f = std::string_view(fresh.data() + (f.data() - oldBegin), f.size());
+        row.scratch.swap(fresh);
+    }
+
+    // Первый символ из {разделитель, '\n', '"'} начиная с p
+    const char* nextStructural(const char* p) {
+        if (p >= end_) return end_;
+        if (p >= blockBase_ + 64) loadBlock(p);
+        uint64_t m = mask_ & (~uint64_t(0) << (p - blockBase_));
+        while (m == 0) {
+            if (blockBase_ + 64 >= end_) return end_;
+            loadBlock(blockBase_ + 64);
+            m = mask_;
+        }
+        const char* r = blockBase_ + ctz64(m);
+        return r < end_ ? r : end_;
+    }
+
+    void loadBlock(const char* p) {
+        blockBase_ = begin_ + ((p - begin_) & ~std::ptrdiff_t(63));
+        if (end_ - blockBase_ >= 64) {
+            mask_ = structuralMask(blockBase_);
+        } else {
+            alignas(64) char tail[64] = {};
+            std::memcpy(tail, blockBase_, static_cast<size_t>(end_ - blockBase_));
+            mask_ = structuralMask(tail);
+        }
+    }
+
+    static int ctz64(uint64_t m) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(m);
+#else
+        int n = 0;
+        while (!(m & 1)) { m >>= 1; ++n; }
+        return n;
+#endif
+    }
+
+    uint64_t structuralMask(const char* p) const {
+#if defined(__AVX2__)
+        const __m256i d = _mm256_set1_epi8(delim_), nl = _mm256_set1_epi8('\n'), q = _mm256_set1_epi8('"');
+        uint64_t m = 0;
+        for (int i = 0; i < 2; ++i) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+            __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, d), _mm256_cmpeq_epi8(v, nl)),
+                                          _mm256_cmpeq_epi8(v, q));
+            m |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(hit))) << (32 * i);
+        }
+        return m;
+#elif defined(__SSE2__)
+        const __m128i d = _mm_set1_epi8(delim_), nl = _mm_set1_epi8('\n'), q = _mm_set1_epi8('"');
+        uint64_t m = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+            __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, nl)),
+                                       _mm_cmpeq_epi8(v, q));
+            m |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(hit))) << (16 * i);
+        }
+        return m;
+#elif defined(__ARM_NEON)
+        const uint8x16_t d = vdupq_n_u8(static_cast<uint8_t>(delim_)), nl = vdupq_n_u8('\n'), q = vdupq_n_u8('"');
+        static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        const uint8x16_t w = vld1q_u8(weights);
+        uint64_t m = 0;
+        for (int i = 0; i < 4; ++i) {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + 16 * i));
+            uint8x16_t hit = vandq_u8(vorrq_u8(vorrq_u8(vceqq_u8(v, d), vceqq_u8(v, nl)), vceqq_u8(v, q)), w);
+            uint64_t bits = vaddv_u8(vget_low_u8(hit)) | (uint64_t(vaddv_u8(vget_high_u8(hit))) << 8);
+            m |= bits << (16 * i);
+        }
+        return m;
+#else
+        uint64_t m = 0;
+        for (int i = 0; i < 64; ++i)
+            if (p[i] == delim_ || p[i] == '\n' || p[i] == '"') m |= uint64_t(1) << i;
+        return m;
+#endif
+    }
+
+    const char* begin_;
+    const char* end_;
+    const char* cur_;
+    const char* blockBase_ = nullptr;
+    uint64_t mask_ = 0;
+    char delim_;
+};
+
+// Разбор чисел без локали и без аллокаций
+inline bool parseInt(std::string_view s, int& out) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+inline bool parseDouble(std::string_view s, double& out) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+#if defined(__cpp_lib_to_chars)
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+#else
+    // libc++ без from_chars для double
+    char tmp[64];
+    if (s.empty() || s.size() >= sizeof(tmp)) return false;
+    std::memcpy(tmp, s.data(), s.size());
+    tmp[s.size()] = '\0';
+    char* e;
+    out = std::strtod(tmp, &e);
+    return e == tmp + s.size();
+#endif
+}
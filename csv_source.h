@@ -0,0 +1,319 @@
+#pragma once
+
+// Источник CSV для ETL: обычный файл разбирается прямо из mmap, сжатый
+// (gzip или zstd, определяется по сигнатуре) распаковывается в отдельном
+// потоке. Распаковщик заполняет кольцо буферов, разборщик забирает их по
+// порядку; запись, разрезанная границей буфера, переносится в начало
+// следующего окна. Так с диска читается в разы меньше, а разбор идёт
+// одновременно с распаковкой.
+// zstd из нескольких независимых кадров (pzstd, склеенные файлы)
+// распаковывается параллельно по кадрам на всех ядрах.
+// gzip - всегда (zlib), zstd - при сборке с ETL_WITH_ZSTD (libzstd).
+// Оборванный или испорченный сжатый файл отдаётся до места ошибки, без
+// оборванной записи, а CsvSource::error() сообщает об ошибке.
+
+#include "csv_reader.h"
+#include "spsc_queue.h"
+
+#include <zlib.h>
+#if defined(ETL_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+enum class Compression { None, Gzip, Zstd };
+
+inline Compression detectCompression(std::string_view head) {
+    if (head.size() >= 2 && uint8_t(head[0]) == 0x1f && uint8_t(head[1]) == 0x8b) return Compression::Gzip;
+    if (head.size() >= 4 && std::memcmp(head.data(), "\x28\xb5\x2f\xfd", 4) == 0) return Compression::Zstd;
+    return Compression::None;
+}
+
+inline const char* compressionName(Compression c) {
+    switch (c) {
+        case Compression::Gzip: return "gzip";
+        case Compression::Zstd: return "zstd";
+        default: return "none";
+    }
+}
+
+// Входной файл: name, а если его нет - name.gz или name.zst
+inline std::string findCsv(const std::string& name) {
+    for (const char* ext : {"", ".gz", ".zst"}) {
+        std::string path = name + ext;
+        if (access(path.c_str(), R_OK) == 0) return path;
+    }
+    return name;
+}
+
+// Поток распаковки: input -> кольцо буферов. input должен жить дольше объекта.
+class Decompressor {
+public:
+    static constexpr size_t kChunkBytes = 1 << 20;
+
+    Decompressor(std::string_view input, Compression kind, size_t ringBuffers = 8)
+        : input_(input), filled_(ringBuffers), free_(ringBuffers) {
+        thread_ = std::thread([this, kind] {
+            if (kind == Compression::Gzip) inflateGzip();
+            else decompressZstd();
+            filled_.close();
+        });
+    }
+
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    ~Decompressor() {
+        stop_.store(true, std::memory_order_release);
+        thread_.join();
+    }
+
+    // Следующий кусок распакованных данных; false - данные кончились (или ошибка)
+    bool next(std::string& chunk) { return filled_.pop(chunk); }
+
+    // Вернуть прочитанный буфер в кольцо
+    void recycle(std::string& chunk) { free_.tryPush(chunk); }
+
+    // Пусто - без ошибок. Читать после того, как next вернул false.
+    const std::string& error() const { return error_; }
+
+private:
+    std::string buffer() {
+        std::string b;
+        free_.tryPop(b);
+        b.resize(kChunkBytes);
+        return b;
+    }
+
+    bool emit(std::string& chunk) { return filled_.push(chunk, stop_); }
+
+    bool stopped() const { return stop_.load(std::memory_order_acquire); }
+
+    // gzip, в том числе несколько членов подряд (cat a.gz b.gz)
+    void inflateGzip() {
+        z_stream z{};
+        if (inflateInit2(&z, 15 + 32) != Z_OK) {
+            error_ = "gzip: inflateInit2 failed";
+            return;
+        }
+        size_t consumed = 0;
+        std::string out = buffer();
+        size_t used = 0;
+        while (!stopped()) {
+            if (z.avail_in == 0 && consumed < input_.size()) {
+                size_t n = std::min<size_t>(input_.size() - consumed, 1u << 30);  // avail_in - 32 бита
+                z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input_.data() + consumed));
+                z.avail_in = static_cast<uInt>(n);
+                consumed += n;
+            }
+            z.next_out = reinterpret_cast<Bytef*>(&out[used]);
+            z.avail_out = static_cast<uInt>(out.size() - used);
+            int rc = inflate(&z, Z_NO_FLUSH);
+            used = out.size() - z.avail_out;
+            bool inputLeft = z.avail_in > 0 || consumed < input_.size();
+            if (rc == Z_STREAM_END) {
+                if (!inputLeft) break;
+                inflateReset(&z);
+            } else if (rc == Z_BUF_ERROR && !inputLeft) {
+                error_ = "gzip: unexpected end of file";
+                break;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                error_ = std::string("gzip: ") + (z.msg ? z.msg : "corrupt data");
+                break;
+            }
+            if (used == out.size()) {
+                if (!emit(out)) break;
+                out = buffer();
+                used = 0;
+            }
+        }
+        inflateEnd(&z);
+        out.resize(used);
+        if (used) emit(out);  // и при ошибке: оборванную запись отбросит CsvSource
+    }
+
+#if defined(ETL_WITH_ZSTD)
+    static constexpr size_t kMaxParallelFrame = size_t(64) << 20;
+
+    void decompressZstd() {
+        // Границы кадров ищутся без распаковки
+        std::vector<std::string_view> frames;
+        bool parallel = true;
+        for (size_t at = 0; at < input_.size();) {
+            size_t n = ZSTD_findFrameCompressedSize(input_.data() + at, input_.size() - at);
+            if (ZSTD_isError(n)) {
+                // Оборванный или испорченный кадр: потоковая распаковка отдаст всё до него и вернёт ошибку
+                parallel = false;
+                break;
+            }
+            unsigned long long size = ZSTD_getFrameContentSize(input_.data() + at, n);
+            parallel = parallel && size != ZSTD_CONTENTSIZE_UNKNOWN && size != ZSTD_CONTENTSIZE_ERROR &&
+                       size <= kMaxParallelFrame;
+            frames.push_back(input_.substr(at, n));
+            at += n;
+        }
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        if (parallel && frames.size() > 1 && threads > 1) decompressFrames(frames, threads);
+        else streamZstd();
+    }
+
+    // Один кадр или размеры неизвестны: потоковая распаковка кусками
+    void streamZstd() {
+        ZSTD_DCtx* dctx = ZSTD_createDCtx();
+        ZSTD_inBuffer in{input_.data(), input_.size(), 0};
+        size_t pending = 0;
+        while (!stopped()) {
+            std::string out = buffer();
+            ZSTD_outBuffer o{&out[0], out.size(), 0};
+            pending = ZSTD_decompressStream(dctx, &o, &in);
+            if (ZSTD_isError(pending)) {
+                error_ = std::string("zstd: ") + ZSTD_getErrorName(pending);
+                break;
+            }
+            out.resize(o.pos);
+            if (o.pos && !emit(out)) break;
+            if (in.pos == in.size && o.pos < o.size) break;  // всё отдано
+        }
+        if (error_.empty() && pending != 0 && !stopped()) error_ = "zstd: unexpected end of file";
+        ZSTD_freeDCtx(dctx);
+    }
+
+    // Кадры группами по threads: группа распаковывается параллельно и отдаётся по порядку,
+    // пока разборщик читает её, распаковывается следующая
+    void decompressFrames(const std::vector<std::string_view>& frames, unsigned threads) {
+        std::vector<ZSTD_DCtx*> dctx(threads);
+        for (ZSTD_DCtx*& d : dctx) d = ZSTD_createDCtx();
+        std::vector<std::string> out(threads);
+        std::vector<size_t> status(threads);
+        auto unpack = [&](size_t first, unsigned k) {
+            std::string_view f = frames[first + k];
+            out[k].resize(static_cast<size_t>(ZSTD_getFrameContentSize(f.data(), f.size())));
+            status[k] = ZSTD_decompressDCtx(dctx[k], &out[k][0], out[k].size(), f.data(), f.size());
+        };
+        for (size_t first = 0; first < frames.size() && !stopped() && error_.empty(); first += threads) {
+            unsigned count = static_cast<unsigned>(std::min<size_t>(threads, frames.size() - first));
+            std::vector<std::thread> pool;
+            for (unsigned k = 1; k < count; ++k) pool.emplace_back(unpack, first, k);
+            unpack(first, 0);
+            for (std::thread& t : pool) t.join();
+            for (unsigned k = 0; k < count && error_.empty(); ++k) {
+                if (ZSTD_isError(status[k])) {
+                    error_ = std::string("zstd: ") + ZSTD_getErrorName(status[k]);
+                } else {
+                    out[k].resize(status[k]);
+                    if (!out[k].empty() && !emit(out[k])) break;
+                }
+            }
+        }
+        for (ZSTD_DCtx* d : dctx) ZSTD_freeDCtx(d);
+    }
+#else
+    void decompressZstd() { error_ = "zstd input needs a build with ETL_WITH_ZSTD (libzstd)"; }
+#endif
+
+    std::string_view input_;
+    SpscQueue<std::string> filled_, free_;
+    std::atomic<bool> stop_{false};
+    std::string error_;
+    std::thread thread_;
+};
+
+// Записи CSV из обычного или сжатого файла. Поля строки, как и у CsvReader,
+// действительны до следующего вызова next.
+class CsvSource {
+public:
+    CsvSource() : reader_(std::string_view("")) {}
+
+    // from > 0 - читать с этого байта файла (для сжатого - граница кадра или члена gzip)
+    bool open(const std::string& path, size_t from = 0) {
+        if (!file_.open(path)) return false;
+        from = std::min(from, file_.size());
+        kind_ = detectCompression(file_.view());
+        if (kind_ == Compression::None) {
+            base_ = from;
+            reader_ = CsvReader(file_.view().substr(from));
+        } else {
+            inflater_.reset(new Decompressor(file_.view().substr(from), kind_));
+        }
+        return true;
+    }
+
+    // Следующая запись; false - данные кончились (или сжатый файл оборван/испорчен, см. error)
+    bool next(CsvRow& row) {
+        if (!inflater_) {
+            size_t at = reader_.offset();
+            if (!reader_.next(row)) return false;
+            record_ = file_.view().substr(base_ + at, reader_.offset() - at);
+            // Уже разобранные страницы файла больше не нужны - отдаём их ядру
+            size_t off = base_ + reader_.offset();
+            if (off - released_ >= (64u << 20)) {
+                file_.release(off);
+                released_ = off;
+            }
+            return true;
+        }
+        while (true) {
+            size_t at = reader_.offset();
+            bool got = reader_.next(row);
+            size_t end = reader_.offset();
+            // Запись, дошедшая до конца окна, могла оборваться (в том числе внутри
+            // кавычек) - её разбираем заново после дочитывания
+            if (got && (eof_ || end < window_.size())) {
+                record_ = std::string_view(window_).substr(at, end - at);
+                return true;
+            }
+            if (eof_) return false;
+            refill(at);
+        }
+    }
+
+    // Исходный текст последней записи (для файла отказов)
+    std::string_view record() const { return record_; }
+
+    Compression compression() const { return kind_; }
+
+    // Пусто - файл дочитан без ошибок. Читать после того, как next вернул false.
+    const std::string& error() const { return error_; }
+
+private:
+    // Хвост окна с позиции keep - неполная запись: переносится в начало, к ней дописывается кусок
+    void refill(size_t keep) {
+        window_.erase(0, keep);
+        std::string chunk;
+        if (inflater_->next(chunk)) {
+            window_.append(chunk);
+            inflater_->recycle(chunk);
+        } else {
+            eof_ = true;
+            error_ = inflater_->error();
+            if (!error_.empty()) {
+                std::cerr << "Decompression error: " << error_ << std::endl;
+                // Незавершённая последняя запись оборвана, а не кончилась - её не отдаём
+                window_.resize(window_.rfind('\n') + 1);
+            }
+        }
+        reader_ = CsvReader(window_);
+    }
+
+    MappedFile file_;
+    Compression kind_ = Compression::None;
+    std::unique_ptr<Decompressor> inflater_;
+    CsvReader reader_;
+    std::string window_;
+    std::string_view record_;
+    std::string error_;
+    size_t base_ = 0, released_ = 0;
+    bool eof_ = false;
+};
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include "datagen.h"
+
+int usage() {
+    std::cerr << "Usage:\n"
+                 "  datagen sales   --rows N [--seed S] [--dir DIR]        products/customers/sales.csv\n"
+                 "  datagen devices --rows N [--seed S] [--out FILE]       devices.txt for OAIPrk\n"
+                 "  datagen ops     --rows N [--accounts A] [--seed S] [--out FILE]  operations for RK --batch\n"
+                 "N accepts K/M suffixes: 10K, 100M" << std::endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    std::string kind = argv[1];
+    size_t rows = 1000000, accounts = 100000;
+    uint64_t seed = 42;
+    std::string dir = ".", out;
+    for (int i = 2; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--rows") && i + 1 < argc) rows = parseCount(argv[++i]);
+        else if (!std::strcmp(argv[i], "--accounts") && i + 1 < argc) accounts = parseCount(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) seed = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) out = argv[++i];
+        else return usage();
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok;
+    if (kind == "sales") {
+        SalesSize size = SalesSize::forSales(rows);
+        ok = generateSalesCsv(dir, size, seed);
+        if (ok)
+            std::cout << "📦 " << size.products << " products, " << size.customers << " customers, "
+                      << size.sales << " sales -> " << dir << std::endl;
+    } else if (kind == "devices") {
+        if (out.empty()) out = "devices.txt";
+        ok = generateDevicesText(out, rows, seed);
+        if (ok) std::cout << "📦 " << rows << " devices -> " << out << std::endl;
+    } else if (kind == "ops") {
+        if (out.empty()) out = "operations.csv";
+        ok = generateBankOps(out, accounts, rows, seed);
+        if (ok) std::cout << "📦 " << accounts << " accounts, " << rows << " operations -> " << out << std::endl;
+    } else {
+        return usage();
+    }
+    if (!ok) {
+        std::cerr << "Cannot write output" << std::endl;
+        return 1;
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "⏱  " << sec << " s (seed " << seed << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+// Синтетические данные для бенчмарков, воспроизводимые по seed.
+// Продажи: products.csv / customers.csv / sales.csv в формате, который читает
+// main.cpp. Популярность товаров и покупателей - закон Ципфа (немногие
+// товары дают большую часть продаж), категории и регионы тоже неравные,
+// даты продаж идут по возрастанию, как в реальной выгрузке.
+// Устройства: devices.txt для OAIPrk.cpp, бренды с тем же перекосом.
+// Операции банка: файл для RK.cpp --batch.
+// Пишется потоком через буфер, в памяти только таблицы выбора, поэтому
+// размер ограничен диском, а не памятью (100M продаж - около 4 ГБ).
+
+#include "date_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// "10000", "10K", "100M" -> число строк (параметры --rows у datagen и bench)
+inline size_t parseCount(const std::string& s) {
+    size_t pos = 0;
+    size_t n = std::stoul(s, &pos);
+    if (pos < s.size() && (s[pos] == 'K' || s[pos] == 'k')) n *= 1000;
+    else if (pos < s.size() && (s[pos] == 'M' || s[pos] == 'm')) n *= 1000000;
+    return n;
+}
+
+// Буферизованная запись: куски по 1 МБ уходят одним fwrite
+class FileWriter {
+public:
+    FileWriter() { buf_.reserve(kFlushBytes + 256); }
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+    ~FileWriter() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        file_ = std::fopen(path.c_str(), "wb");
+        ok_ = file_ != nullptr;
+        return ok_;
+    }
+
+    // false - файл не открылся или запись не удалась
+    bool close() {
+        if (!file_) return ok_;
+        flush();
+        ok_ = std::fclose(file_) == 0 && ok_;
+        file_ = nullptr;
+        return ok_;
+    }
+
+    FileWriter& put(std::string_view s) {
+        buf_.append(s.data(), s.size());
+        if (buf_.size() >= kFlushBytes) flush();
+        return *this;
+    }
+
+    FileWriter& put(char c) {
+        buf_.push_back(c);
+        return *this;
+    }
+
+    FileWriter& putInt(long long v) {
+        char num[24];
+        return put(std::string_view(num, static_cast<size_t>(std::snprintf(num, sizeof(num), "%lld", v))));
+    }
+
+    // Сумма в копейках/центах как "123.45"
+    FileWriter& putCents(long long cents) {
+        char num[32];
+        return put(std::string_view(num, static_cast<size_t>(
+                                             std::snprintf(num, sizeof(num), "%lld.%02lld", cents / 100, cents % 100))));
+    }
+
+private:
+    static constexpr size_t kFlushBytes = 1 << 20;
+
+    void flush() {
+        if (file_ && !buf_.empty() && std::fwrite(buf_.data(), 1, buf_.size(), file_) != buf_.size()) ok_ = false;
+        buf_.clear();
+    }
+
+    std::FILE* file_ = nullptr;
+    std::string buf_;
+    bool ok_ = false;
+};
+
+// Распределение Ципфа на [0, n): P(k) ~ 1 / (k + 1)^s, выбор - двоичный поиск по CDF
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double s) : cdf_(n) {
+        double sum = 0;
+        for (size_t k = 0; k < n; ++k) cdf_[k] = sum += 1.0 / std::pow(double(k + 1), s);
+        for (double& c : cdf_) c /= sum;
+    }
+
+    template <class Rng>
+    size_t operator()(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        return std::min(static_cast<size_t>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin()),
+                        cdf_.size() - 1);
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+// Место по популярности -> id: самые популярные не должны быть просто первыми id
+inline std::vector<int> shuffledIds(size_t n, std::mt19937_64& rng) {
+    std::vector<int> ids(n);
+    for (size_t i = 0; i < n; ++i) ids[i] = static_cast<int>(i + 1);
+    std::shuffle(ids.begin(), ids.end(), rng);
+    return ids;
+}
+
+struct SalesSize {
+    size_t products, customers, sales;
+
+    // Справочники растут медленнее фактов, как в реальном магазине
+    static SalesSize forSales(size_t sales) {
+        return {std::clamp<size_t>(sales / 1000, 100, 100000), std::clamp<size_t>(sales / 50, 100, 2000000), sales};
+    }
+};
+
+inline bool generateSalesCsv(const std::string& dir, const SalesSize& size, uint64_t seed) {
+    static const char* categories[] = {"Electronics", "Clothing", "Home", "Books", "Sports", "Toys",
+                                       "Beauty", "Grocery", "Garden", "Auto", "Music", "Office"};
+    static const char* regions[] = {"Moscow", "Saint Petersburg", "Novosibirsk", "Yekaterinburg",
+                                    "Kazan", "Nizhny Novgorod", "Samara", "Omsk"};
+    std::mt19937_64 rng(seed);
+    ZipfSampler category(12, 1.0), region(8, 0.8);
+
+    // Цена товара нужна для сумм продаж - держим её в центах по id
+    std::vector<long long> priceCents(size.products + 1);
+    FileWriter products;
+    if (!products.open(dir + "/products.csv")) return false;
+    products.put("product_id,product_name,category,price\n");
+    std::lognormal_distribution<double> price(3.5, 1.2);  // медиана около 33, хвост до тысяч
+    for (size_t id = 1; id <= size.products; ++id) {
+        priceCents[id] = std::clamp<long long>(std::llround(price(rng) * 100), 99, 999999);
+        products.putInt(static_cast<long long>(id)).put(",Product ").putInt(static_cast<long long>(id)).put(',');
+        products.put(categories[category(rng)]).put(',').putCents(priceCents[id]).put('\n');
+    }
+
+    FileWriter customers;
+    if (!customers.open(dir + "/customers.csv")) return false;
+    customers.put("customer_id,customer_name,region\n");
+    for (size_t id = 1; id <= size.customers; ++id) {
+        customers.putInt(static_cast<long long>(id)).put(",Customer ").putInt(static_cast<long long>(id)).put(',');
+        customers.put(regions[region(rng)]).put('\n');
+    }
+
+    ZipfSampler product(size.products, 1.1), customer(size.customers, 0.7);
+    std::vector<int> productIds = shuffledIds(size.products, rng), customerIds = shuffledIds(size.customers, rng);
+    std::geometric_distribution<int> extra(0.6);  // количество 1, 2, ... всё реже
+    FileWriter sales;
+    if (!sales.open(dir + "/sales.csv")) return false;
+    sales.put("sale_id,sale_date,product_id,customer_id,quantity,amount\n");
+    const int32_t day0 = daysFromCivil(2022, 1, 1), days = daysFromCivil(2025, 1, 1) - day0;
+    char date[11] = {};
+    for (size_t i = 0; i < size.sales; ++i) {
+        formatDate(day0 + static_cast<int32_t>(i * static_cast<size_t>(days) / size.sales), date);
+        int p = productIds[product(rng)];
+        int quantity = 1 + std::min(extra(rng), 19);
+        long long amount = priceCents[p] * quantity;
+        if (rng() % 10 == 0) amount = amount * 9 / 10;  // скидка у каждой десятой
+        sales.putInt(static_cast<long long>(i + 1)).put(',').put(std::string_view(date, 10)).put(',');
+        sales.putInt(p).put(',').putInt(customerIds[customer(rng)]).put(',').putInt(quantity).put(',');
+        sales.putCents(amount).put('\n');
+    }
+    return products.close() && customers.close() && sales.close();
+}
+
+// Одно устройство для devices.txt; строки указывают в статические таблицы
+struct DeviceSpec {
+    bool phone = false;
+    std::string_view brand, os;  // os - только у смартфона
+    std::string model;
+    long long priceCents = 0;
+    int memory = 0;              // смартфон
+    double screen = 0;           // ноутбук
+    int battery = 0;
+    std::vector<std::string_view> apps;
+};
+
+// Устройства по одному в emit(const DeviceSpec&): бенчмарки берут их из памяти,
+// generateDevicesText пишет в файл
+template <class Emit>
+inline void generateDevices(size_t n, uint64_t seed, Emit&& emit) {
+    static const char* brands[] = {"Apple", "Samsung", "Xiaomi", "Lenovo", "Asus", "Dell",
+                                   "HP", "Huawei", "Acer", "Google", "Sony", "Honor"};
+    static const char* oses[] = {"Android", "iOS", "HarmonyOS"};
+    static const char* apps[] = {"Telegram", "WhatsApp", "Chrome", "Office", "Spotify", "YouTube",
+                                 "Zoom", "Slack", "VSCode", "Steam", "Maps", "Camera"};
+    static const double screens[] = {13.3, 14, 15.6, 16, 17.3};
+    std::mt19937_64 rng(seed);
+    ZipfSampler brand(12, 0.9), app(12, 0.8);
+    DeviceSpec d;
+    for (size_t i = 0; i < n; ++i) {
+        d.phone = rng() % 2;
+        d.brand = brands[brand(rng)];
+        d.model = "Model-" + std::to_string(rng() % (n / 4 + 100));
+        d.priceCents = static_cast<long long>(10000 + rng() % 290000);
+        if (d.phone) {
+            d.os = oses[rng() % 3];
+            d.memory = 64 << (rng() % 5);
+        } else {
+            d.os = std::string_view();
+            d.screen = screens[rng() % 5];
+            d.battery = static_cast<int>(40 + rng() % 60);
+        }
+        d.apps.clear();
+        for (size_t k = rng() % 5; k > 0; --k) d.apps.push_back(apps[app(rng)]);
+        emit(d);
+    }
+}
+
+// devices.txt: тип;бренд;модель;цена;параметр;приложения
+inline bool generateDevicesText(const std::string& path, size_t n, uint64_t seed) {
+    FileWriter out;
+    if (!out.open(path)) return false;
+    char num[32];
+    generateDevices(n, seed, [&](const DeviceSpec& d) {
+        out.put(d.phone ? "Smartphone;" : "Laptop;").put(d.brand).put(';').put(d.model).put(';');
+        out.putCents(d.priceCents).put(';');
+        if (d.phone) out.put(d.os).put('-').putInt(d.memory).put(';');
+        else out.put(std::string_view(num, static_cast<size_t>(std::snprintf(num, sizeof(num), "%g", d.screen))))
+                 .put('-').putInt(d.battery).put(';');
+        for (size_t k = 0; k < d.apps.size(); ++k) {
+            if (k) out.put('|');
+            out.put(d.apps[k]);
+        }
+        out.put('\n');
+    });
+    return out.close();
+}
+
+// Номер счета вида RU + 20 цифр
+inline std::string accountNumberFor(size_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "RU%020zu", i);
+    return buf;
+}
+
+// Файл операций для RK.cpp --batch: сначала OPEN всех счетов, затем случайная смесь
+inline bool generateBankOps(const std::string& path, size_t accounts, size_t ops, uint64_t seed) {
+    FileWriter out;
+    if (!out.open(path)) return false;
+    std::mt19937_64 rng(seed);
+    out.put("op,account,amount,extra\n");
+    for (size_t i = 0; i < accounts; i++) {
+        out.put("OPEN,").put(accountNumberFor(i)).put(',').putInt(static_cast<long long>(1000 + rng() % 100000));
+        out.put(",Клиент ").putInt(static_cast<long long>(i));
+        if (i % 2) out.put(',').putInt(static_cast<long long>(3 + rng() % 6));
+        out.put('\n');
+    }
+    for (size_t i = 0; i < ops; i++) {
+        unsigned kind = unsigned(rng() % 20);
+        long long rubles = static_cast<long long>(rng() % 5000);
+        long long cents = rubles * 100 + static_cast<long long>(rng() % 100);
+        std::string a = accountNumberFor(rng() % accounts);
+        if (kind < 7) out.put("DEPOSIT,").put(a).put(',').putCents(cents).put('\n');
+        else if (kind < 13) out.put("WITHDRAW,").put(a).put(',').putCents(cents).put('\n');
+        else if (kind < 18) out.put("TRANSFER,").put(a).put(',').putCents(cents).put(',').put(accountNumberFor(rng() % accounts)).put('\n');
+        else if (kind < 19) out.put("ACCRUE,").put(accountNumberFor((rng() % accounts) | 1)).put('\n');  // нечетные - сберегательные
+        else out.put("RATE,").put(accountNumberFor((rng() % accounts) | 1)).put(',').putInt(static_cast<long long>(3 + rng() % 6)).put('\n');
+    }
+    return out.close();
+}
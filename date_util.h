@@ -0,0 +1,148 @@
+#pragma once
+
+// Даты как число дней с 1970-01-01: разбор YYYY-MM-DD без аллокаций,
+// форматирование только по требованию, календарные поля для time_dim.
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Гражданская дата <-> число дней с 1970-01-01 (пролептический григорианский календарь)
+inline int32_t daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int32_t>(doe) - 719468;
+}
+
+inline void civilFromDays(int32_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+}
+
+inline bool isLeapYear(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+inline unsigned daysInMonth(int y, unsigned m) {
+    static const unsigned char kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeapYear(y) ? 29 : kDays[m - 1];
+}
+
+// YYYY-MM-DD (месяц и день - одна или две цифры); false - не дата
+inline bool parseDate(std::string_view s, int32_t& days) {
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\r')) s.remove_suffix(1);
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    size_t i = 0;
+    auto number = [&](size_t minDigits, size_t maxDigits, unsigned& out) {
+        size_t start = i;
+        out = 0;
+        while (i < s.size() && i - start < maxDigits && s[i] >= '0' && s[i] <= '9')
+            out = out * 10 + static_cast<unsigned>(s[i++] - '0');
+        return i - start >= minDigits;
+    };
+    unsigned y, m, d;
+    if (!number(4, 4, y) || i >= s.size() || s[i++] != '-') return false;
+    if (!number(1, 2, m) || i >= s.size() || s[i++] != '-') return false;
+    if (!number(1, 2, d) || i != s.size()) return false;
+    if (m < 1 || m > 12 || d < 1 || d > daysInMonth(static_cast<int>(y), m)) return false;
+    days = daysFromCivil(static_cast<int>(y), m, d);
+    return true;
+}
+
+// Ровно 10 символов YYYY-MM-DD
+inline void formatDate(int32_t days, char out[10]) {
+    int y;
+    unsigned m, d;
+    civilFromDays(days, y, m, d);
+    out[0] = char('0' + y / 1000 % 10);
+    out[1] = char('0' + y / 100 % 10);
+    out[2] = char('0' + y / 10 % 10);
+    out[3] = char('0' + y % 10);
+    out[4] = '-';
+    out[5] = char('0' + m / 10);
+    out[6] = char('0' + m % 10);
+    out[7] = '-';
+    out[8] = char('0' + d / 10);
+    out[9] = char('0' + d % 10);
+}
+
+// 0 - воскресенье ... 6 - суббота (1970-01-01 - четверг)
+inline unsigned weekday(int32_t days) {
+    int r = (days + 4) % 7;
+    return static_cast<unsigned>(r < 0 ? r + 7 : r);
+}
+
+inline const char* weekdayName(unsigned wd) {
+    static const char* kNames[7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    return kNames[wd];
+}
+
+// Строка time_dim
+struct DateParts {
+    int32_t days;
+    int year;
+    unsigned quarter, month, day, dayOfWeek;
+};
+
+inline DateParts dateParts(int32_t days) {
+    DateParts p;
+    p.days = days;
+    civilFromDays(days, p.year, p.month, p.day);
+    p.quarter = (p.month - 1) / 3 + 1;
+    p.dayOfWeek = weekday(days);
+    return p;
+}
+
+// Множество встреченных дат: плотный битсет на 1790..2149 годы,
+// остальное - в хеш-таблицу. Календарные поля считаются один раз на дату.
+class DateSet {
+public:
+    DateSet() : bits_(kSpan / 64, 0) {}
+
+    // true - дата встретилась впервые
+    bool add(int32_t days) {
+        int64_t k = int64_t(days) + kSpan / 2;
+        if (k >= 0 && k < kSpan) {
+            uint64_t& w = bits_[static_cast<size_t>(k / 64)];
+            uint64_t bit = uint64_t(1) << (k % 64);
+            if (w & bit) return false;
+            w |= bit;
+        } else if (!outliers_.insert(days).second) {
+            return false;
+        }
+        ++count_;
+        return true;
+    }
+
+    size_t size() const { return count_; }
+
+    // Все даты по возрастанию
+    std::vector<DateParts> parts() const {
+        std::vector<DateParts> out;
+        out.reserve(count_);
+        std::vector<int32_t> extra(outliers_.begin(), outliers_.end());
+        std::sort(extra.begin(), extra.end());
+        for (int32_t d : extra) if (d < -kSpan / 2) out.push_back(dateParts(d));
+        for (size_t w = 0; w < bits_.size(); ++w)
+            for (uint64_t m = bits_[w]; m; m &= m - 1)
+                out.push_back(dateParts(static_cast<int32_t>(int64_t(w) * 64 + __builtin_ctzll(m) - kSpan / 2)));
+        for (int32_t d : extra) if (d >= kSpan / 2) out.push_back(dateParts(d));
+        return out;
+    }
+
+private:
+    static constexpr int64_t kSpan = 1 << 17;
+    std::vector<uint64_t> bits_;
+    std::unordered_set<int32_t> outliers_;
+    size_t count_ = 0;
+};
@@ -0,0 +1,565 @@
+#pragma once
+
+// Каталог устройств без виртуальных вызовов и RTTI.
+// Смартфоны и ноутбуки лежат в двух непрерывных массивах своих записей,
+// поэтому запрос "только смартфоны" - проход по одному массиву без
+// dynamic_cast. Бренд, модель, ОС и названия приложений интернированы
+// (StringPool), списки приложений всех устройств - один общий массив
+// номеров, в записи только начало и длина своего куска.
+// Снаружи устройство адресуется DeviceId - номером слота в таблице
+// слот -> (тип, позиция, поколение). Удаление - перестановка с последним
+// элементом (swap-and-pop): массивы остаются плотными для проходов, слот
+// освобождается и потом достаётся новому устройству. Поколение слота
+// растёт при каждом удалении, поэтому DeviceHandle (слот + поколение),
+// сохранённый до удаления, больше не разрешается (resolve).
+// Изменение и удаление по id - O(1) (индекс цен - O(log n)).
+// order() - порядок показа в меню: порядок добавления, затем сортировки.
+// Удалённые из него вычищаются лениво, при следующем чтении; до этого
+// их слоты не переиспользуются. removeIf удаляет много устройств за
+// один проход по массивам и индексам.
+// Индексы (DeviceIndex) и представление "бренд, цена" для сортировки
+// обновляются здесь же при добавлении, изменении и удалении.
+// search() - поиск по бренду, модели и приложениям (TextIndex) в лучшем
+// порядке. Текстовый индекс ведётся по различным строкам, а не по
+// устройствам: новые строки пулов дописываются в него перед запросом,
+// устройства берутся из списков DeviceIndex, которые уже актуальны.
+
+#include "device_index.h"
+#include "device_search.h"
+#include "string_pool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+enum class DeviceType : uint8_t { Smartphone, Laptop, None };
+
+using DeviceId = uint32_t;
+
+// Ссылка на устройство, переживающая удаления: после удаления и повторного
+// использования слота поколение не совпадёт
+struct DeviceHandle {
+    DeviceId id;
+    uint32_t generation;
+};
+
+struct DeviceCommon {
+    DeviceId id;
+    uint32_t brand, model;          // номера в brands() / models()
+    uint32_t appsBegin, appsCount;  // кусок общего списка приложений
+    double price;
+};
+
+struct PhoneRecord {
+    DeviceCommon common;
+    uint32_t os;
+    int32_t memory;   // ГБ
+};
+
+struct LaptopRecord {
+    DeviceCommon common;
+    double screen;    // дюймы
+    int32_t battery;  // Вт·ч
+};
+
+enum class SearchField : uint8_t { Brand, Model, App };
+
+struct SearchHit {
+    DeviceId id;
+    SearchField field;
+    uint32_t name;       // номер в brands() / models() / appNames()
+    MatchKind kind;
+    uint32_t distance;   // опечаток (Fuzzy) или дописанных символов (Prefix)
+};
+
+// Устройства, разобранные отдельно от каталога (например, в потоке
+// загрузки): строки интернированы в собственные пулы пакета. append()
+// переносит пакет в каталог, перекодируя номер каждой строки один раз.
+struct DeviceBatch {
+    struct Item {
+        DeviceType type;
+        uint32_t brand, model, os;      // номера в пулах пакета; os - у смартфона
+        uint32_t appsBegin, appsCount;  // кусок apps
+        int32_t memory, battery;
+        double price, screen;
+    };
+
+    std::vector<Item> items;
+    std::vector<uint32_t> apps;
+    StringPool brands, models, oses, appNames;
+};
+
+class DeviceCatalog {
+public:
+    DeviceId addSmartphone(std::string_view brand, std::string_view model, double price,
+                           const std::vector<std::string_view>& apps, std::string_view os, int memory) {
+        return insert(PhoneRecord{makeCommon(brand, model, price, apps), oses_.intern(os), memory});
+    }
+
+    DeviceId addLaptop(std::string_view brand, std::string_view model, double price,
+                       const std::vector<std::string_view>& apps, double screen, int battery) {
+        return insert(LaptopRecord{makeCommon(brand, model, price, apps), screen, battery});
+    }
+
+    void append(const DeviceBatch& batch) {
+        auto remap = [](const StringPool& from, StringPool& to) {
+            std::vector<uint32_t> ids(from.count());
+            for (uint32_t i = 0; i < ids.size(); ++i) ids[i] = to.intern(from.name(i));
+            return ids;
+        };
+        std::vector<uint32_t> brand = remap(batch.brands, brands_), model = remap(batch.models, models_),
+                              os = remap(batch.oses, oses_), app = remap(batch.appNames, appNames_);
+        size_t phones = 0;
+        for (const DeviceBatch::Item& it : batch.items) phones += it.type == DeviceType::Smartphone;
+        reserve(phones_.size() + phones, laptops_.size() + batch.items.size() - phones);
+        appList_.reserve(appList_.size() + batch.apps.size());
+        for (const DeviceBatch::Item& it : batch.items) {
+            DeviceCommon c;
+            c.id = takeSlot();
+            c.brand = brand[it.brand];
+            c.model = model[it.model];
+            c.appsBegin = static_cast<uint32_t>(appList_.size());
+            c.appsCount = it.appsCount;
+            c.price = it.price;
+            for (uint32_t k = 0; k < it.appsCount; ++k) appList_.push_back(app[batch.apps[it.appsBegin + k]]);
+            if (it.type == DeviceType::Smartphone) insert(PhoneRecord{c, os[it.os], it.memory});
+            else insert(LaptopRecord{c, it.screen, it.battery});
+        }
+    }
+
+    bool remove(DeviceId id) {
+        if (!contains(id)) return false;
+        Slot slot = slots_[id];
+        const DeviceCommon& c = common(id);
+        uint32_t os = slot.type == DeviceType::Smartphone ? phone(id).os : DeviceIndex::kNoOs;
+        index_.remove(id, c.brand, c.model, os, c.price, apps(c), c.appsCount);
+        if (brandPriceFresh(c)) brandPrice_.remove(brandPriceKey(c));
+        garbageApps_ += c.appsCount;
+        if (slot.type == DeviceType::Smartphone) swapPop(phones_, slot.index);
+        else swapPop(laptops_, slot.index);
+        retire(id);
+        return true;
+    }
+
+    bool remove(DeviceHandle h) {
+        DeviceId id;
+        return resolve(h, id) && remove(id);
+    }
+
+    // Удалить все устройства, для которых dead(id) истинно; возвращает их число.
+    // Один проход по каждому массиву и индексу цен вместо удаления по одному;
+    // порядок оставшихся в phones()/laptops() и order() сохраняется.
+    template <class Dead>
+    size_t removeIf(Dead dead) {
+        std::vector<char> gone(slots_.size(), 0);
+        size_t count = 0;
+        for (DeviceId id = 0; id < slots_.size(); ++id) {
+            if (contains(id) && dead(id)) {
+                gone[id] = 1;
+                ++count;
+            }
+        }
+        if (!count) return 0;
+        auto isGone = [&](uint32_t id) { return gone[id] != 0; };
+        for (const PhoneRecord& p : phones_)
+            if (gone[p.common.id]) unlist(p.common, p.os);
+        for (const LaptopRecord& l : laptops_)
+            if (gone[l.common.id]) unlist(l.common, DeviceIndex::kNoOs);
+        index_.price().removeIf(isGone);
+        brandPrice_.removeIf(isGone);
+        compactRecords(phones_, gone);
+        compactRecords(laptops_, gone);
+        for (DeviceId id = 0; id < slots_.size(); ++id)
+            if (gone[id]) retire(id);
+        compactOrder();
+        if (garbageApps_ > 4096 && garbageApps_ * 2 > appList_.size()) compactApps();
+        return count;
+    }
+
+    void clear() { *this = DeviceCatalog(); }
+
+    // Общее число смартфонов и ноутбуков, под которое готовятся массивы
+    void reserve(size_t phones, size_t laptops) {
+        phones_.reserve(phones);
+        laptops_.reserve(laptops);
+        slots_.reserve(phones + laptops);
+        order_.reserve(phones + laptops);
+    }
+
+    bool contains(DeviceId id) const { return id < slots_.size() && slots_[id].type != DeviceType::None; }
+    DeviceType type(DeviceId id) const { return contains(id) ? slots_[id].type : DeviceType::None; }
+    size_t size() const { return phones_.size() + laptops_.size(); }
+
+    DeviceHandle handle(DeviceId id) const { return {id, slots_[id].generation}; }
+
+    // false - устройство по ссылке удалено (слот пуст или уже занят другим)
+    bool resolve(DeviceHandle h, DeviceId& id) const {
+        if (!contains(h.id) || slots_[h.id].generation != h.generation) return false;
+        id = h.id;
+        return true;
+    }
+
+    const DeviceCommon& common(DeviceId id) const {
+        const Slot& slot = slots_[id];
+        return slot.type == DeviceType::Smartphone ? phones_[slot.index].common : laptops_[slot.index].common;
+    }
+    const PhoneRecord& phone(DeviceId id) const { return phones_[slots_[id].index]; }
+    const LaptopRecord& laptop(DeviceId id) const { return laptops_[slots_[id].index]; }
+
+    const std::vector<PhoneRecord>& phones() const { return phones_; }
+    const std::vector<LaptopRecord>& laptops() const { return laptops_; }
+
+    // Вычищает удалённые с прошлого чтения; вызывать из одного потока
+    const std::vector<DeviceId>& order() const {
+        if (!retired_.empty()) compactOrder();
+        return order_;
+    }
+
+    std::string_view brand(const DeviceCommon& c) const { return brands_.name(c.brand); }
+    std::string_view model(const DeviceCommon& c) const { return models_.name(c.model); }
+    std::string_view os(const PhoneRecord& p) const { return oses_.name(p.os); }
+    const uint32_t* apps(const DeviceCommon& c) const { return appList_.data() + c.appsBegin; }
+    const StringPool& brands() const { return brands_; }
+    const StringPool& models() const { return models_; }
+    const StringPool& appNames() const { return appNames_; }
+    const StringPool& oses() const { return oses_; }
+    DeviceIndex& index() { return index_; }
+
+    void setPrice(DeviceId id, double price) {
+        DeviceCommon& c = mutableCommon(id);
+        index_.updatePrice(id, c.price, price);
+        bool fresh = brandPriceFresh(c);
+        if (fresh) brandPrice_.remove(brandPriceKey(c));
+        c.price = price;
+        if (fresh) brandPrice_.add(brandPriceKey(c));
+    }
+
+    void setModel(DeviceId id, std::string_view model) {
+        DeviceCommon& c = mutableCommon(id);
+        uint32_t code = models_.intern(model);
+        index_.updateModel(id, c.model, code);
+        c.model = code;
+    }
+
+    void addApp(DeviceId id, std::string_view app) {
+        DeviceCommon& c = mutableCommon(id);
+        if (c.appsBegin + c.appsCount != appList_.size()) {
+            // Кусок не в конце общего списка - переносим его в конец
+            appList_.reserve(appList_.size() + c.appsCount + 1);
+            uint32_t begin = static_cast<uint32_t>(appList_.size());
+            for (uint32_t i = 0; i < c.appsCount; ++i) appList_.push_back(appList_[c.appsBegin + i]);
+            garbageApps_ += c.appsCount;
+            c.appsBegin = begin;
+        }
+        appList_.push_back(appNames_.intern(app));
+        index_.addApp(id, appList_.back());
+        ++c.appsCount;
+        if (garbageApps_ > 4096 && garbageApps_ * 2 > appList_.size()) compactApps();
+    }
+
+    // Сортировки порядка показа: копия готового представления, а не
+    // сортировка. При равной цене - порядок добавления (или смены цены).
+    void sortByPrice() {
+        const std::vector<SortKey>& keys = index_.price().sorted();
+        order_.clear();
+        for (const SortKey& k : keys) order_.push_back(k.id);
+        releaseRetired();
+    }
+
+    // Бренд по алфавиту, внутри бренда - от дорогих к дешёвым
+    void sortByBrandPrice() {
+        if (brandRank_.size() != brands_.count()) rebuildBrandPrice();
+        const std::vector<SortKey>& keys = brandPrice_.keys();
+        order_.clear();
+        for (const SortKey& k : keys) order_.push_back(k.id);
+        releaseRetired();
+    }
+
+    // Не больше limit устройств, у которых бренд, модель или приложение
+    // совпадает с query точно, по началу (в том числе любого слова) или с
+    // опечатками; лучшие совпадения первыми, устройство - один раз
+    std::vector<SearchHit> search(std::string_view query, size_t limit) {
+        syncSearch();
+        std::vector<SearchHit> hits;
+        if (!limit) return hits;
+        std::unordered_set<DeviceId> seen;
+        text_.find(query, [&](uint32_t term, MatchKind kind, uint32_t distance) {
+            const SearchTerm& t = searchTerms_[term];
+            return postings(t).forEachWhile([&](DeviceId id) {
+                if (seen.insert(id).second) hits.push_back({id, t.field, t.name, kind, distance});
+                return hits.size() < limit;
+            });
+        });
+        return hits;
+    }
+
+    // Дописать в текстовый индекс новые строки пулов. Пулы только растут:
+    // хватает помнить, сколько строк каждого уже там. search() вызывает сам;
+    // отдельно - чтобы построить индекс заранее, а не на первом запросе.
+    void syncSearch() {
+        indexNames(brands_, SearchField::Brand, searchedBrands_);
+        indexNames(models_, SearchField::Model, searchedModels_);
+        indexNames(appNames_, SearchField::App, searchedApps_);
+    }
+
+    std::string_view name(const SearchHit& h) const {
+        const StringPool& pool = h.field == SearchField::Brand   ? brands_
+                                 : h.field == SearchField::Model ? models_
+                                                                 : appNames_;
+        return pool.name(h.name);
+    }
+
+    // Номер бренда -> место бренда в алфавитном порядке
+    std::vector<uint32_t> brandRanks() const {
+        std::vector<uint32_t> byName(brands_.count()), rank(brands_.count());
+        std::iota(byName.begin(), byName.end(), 0);
+        std::sort(byName.begin(), byName.end(),
+                  [&](uint32_t a, uint32_t b) { return brands_.name(a) < brands_.name(b); });
+        for (uint32_t i = 0; i < byName.size(); ++i) rank[byName[i]] = i;
+        return rank;
+    }
+
+    // Тот же вывод, что у ElectronicDevice::display и наследников
+    void display(DeviceId id, std::ostream& out) const {
+        const DeviceCommon& c = common(id);
+        bool isPhone = slots_[id].type == DeviceType::Smartphone;
+        out << (isPhone ? "[Smartphone] " : "[Laptop] ");
+        out << "Brand: " << brand(c) << ", Model: " << model(c)
+            << ", Price: $" << std::fixed << std::setprecision(2) << c.price
+            << ", Apps: ";
+        for (uint32_t i = 0; i < c.appsCount; ++i) out << appNames_.name(apps(c)[i]) << " ";
+        out << std::endl;
+        if (isPhone) {
+            const PhoneRecord& p = phone(id);
+            out << "  OS: " << os(p) << ", Memory: " << p.memory << "GB" << std::endl;
+        } else {
+            const LaptopRecord& l = laptop(id);
+            out << "  Screen: " << l.screen << "\", Battery: " << l.battery << "Wh" << std::endl;
+        }
+    }
+
+    // Строка файла в формате ElectronicDevice::saveToFile
+    void appendText(DeviceId id, std::string& out) const {
+        const DeviceCommon& c = common(id);
+        bool isPhone = slots_[id].type == DeviceType::Smartphone;
+        out.append(isPhone ? "Smartphone;" : "Laptop;").append(brand(c)).append(";").append(model(c)).append(";");
+        appendNumber(out, c.price);
+        out.append(";");
+        for (uint32_t i = 0; i < c.appsCount; ++i) {
+            out.append(appNames_.name(apps(c)[i]));
+            if (i + 1 != c.appsCount) out.append("|");
+        }
+        if (isPhone) {
+            const PhoneRecord& p = phone(id);
+            out.append(";").append(os(p)).append("-");
+            appendNumber(out, p.memory);
+        } else {
+            const LaptopRecord& l = laptop(id);
+            out.append(";");
+            appendNumber(out, l.screen);
+            out.append("-");
+            appendNumber(out, l.battery);
+        }
+        out.append("\n");
+    }
+
+private:
+    struct SearchTerm {
+        SearchField field;
+        uint32_t name;
+    };
+
+    struct Slot {
+        DeviceType type;
+        uint32_t index;       // позиция в phones_ / laptops_
+        uint32_t generation;  // +1 при каждом удалении из слота
+    };
+
+    // Число так же, как его пишет ostream по умолчанию: %g, 6 значащих цифр
+    static void appendNumber(std::string& out, double v) {
+        char buf[32];
+#if defined(__cpp_lib_to_chars)
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, 6).ptr);
+#else
+        // libc++ без to_chars для double
+        out.append(buf, static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%g", v)));
+#endif
+    }
+
+    static void appendNumber(std::string& out, int32_t v) {
+        char buf[16];
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+    }
+
+    DeviceCommon makeCommon(std::string_view brand, std::string_view model, double price,
+                            const std::vector<std::string_view>& apps) {
+        DeviceCommon c;
+        c.id = takeSlot();
+        c.brand = brands_.intern(brand);
+        c.model = models_.intern(model);
+        c.appsBegin = static_cast<uint32_t>(appList_.size());
+        c.appsCount = static_cast<uint32_t>(apps.size());
+        c.price = price;
+        for (std::string_view a : apps) appList_.push_back(appNames_.intern(a));
+        return c;
+    }
+
+    // Ключ представления "бренд, цена по убыванию"
+    SortKey brandPriceKey(const DeviceCommon& c) const {
+        return SortKey{~priceKey(c.price), brandRank_[c.brand], c.id};
+    }
+
+    // Места брендов сдвигаются с каждым новым брендом - тогда представление
+    // перестраивается целиком при следующей сортировке, а до тех пор не ведётся
+    bool brandPriceFresh(const DeviceCommon& c) const {
+        return brandRank_.size() == brands_.count() && c.brand < brandRank_.size();
+    }
+
+    void rebuildBrandPrice() {
+        brandRank_ = brandRanks();
+        brandPrice_.clear();
+        for (DeviceId id = 0; id < slots_.size(); ++id)
+            if (contains(id)) brandPrice_.add(brandPriceKey(common(id)));
+    }
+
+    DeviceId insert(const PhoneRecord& r) {
+        if (brandPriceFresh(r.common)) brandPrice_.add(brandPriceKey(r.common));
+        index_.add(r.common.id, r.common.brand, r.common.model, r.os, r.common.price, apps(r.common),
+                   r.common.appsCount);
+        place(r.common.id, DeviceType::Smartphone, phones_.size());
+        phones_.push_back(r);
+        order_.push_back(r.common.id);
+        return r.common.id;
+    }
+
+    DeviceId insert(const LaptopRecord& r) {
+        if (brandPriceFresh(r.common)) brandPrice_.add(brandPriceKey(r.common));
+        index_.add(r.common.id, r.common.brand, r.common.model, DeviceIndex::kNoOs, r.common.price, apps(r.common),
+                   r.common.appsCount);
+        place(r.common.id, DeviceType::Laptop, laptops_.size());
+        laptops_.push_back(r);
+        order_.push_back(r.common.id);
+        return r.common.id;
+    }
+
+    void unlist(const DeviceCommon& c, uint32_t os) {
+        index_.removeFromLists(c.id, c.brand, c.model, os, apps(c), c.appsCount);
+    }
+
+    const IdBitmap& postings(const SearchTerm& t) const {
+        switch (t.field) {
+            case SearchField::Brand: return index_.byBrand(t.name);
+            case SearchField::Model: return index_.byModel(t.name);
+            default: return index_.byApp(t.name);
+        }
+    }
+
+    void indexNames(const StringPool& pool, SearchField field, uint32_t& done) {
+        for (; done < pool.count(); ++done) {
+            text_.add(pool.name(done), static_cast<uint32_t>(searchTerms_.size()));
+            searchTerms_.push_back({field, done});
+        }
+    }
+
+    DeviceCommon& mutableCommon(DeviceId id) {
+        const Slot& slot = slots_[id];
+        return slot.type == DeviceType::Smartphone ? phones_[slot.index].common : laptops_[slot.index].common;
+    }
+
+    // Свободный слот (поколение сохраняется) или новый в конце таблицы
+    DeviceId takeSlot() {
+        if (!free_.empty()) {
+            DeviceId id = free_.back();
+            free_.pop_back();
+            return id;
+        }
+        slots_.push_back({DeviceType::None, 0, 0});
+        return static_cast<DeviceId>(slots_.size() - 1);
+    }
+
+    void place(DeviceId id, DeviceType type, size_t index) {
+        slots_[id].type = type;
+        slots_[id].index = static_cast<uint32_t>(index);
+    }
+
+    // Слот пуст, но ещё упомянут в order_ - свободным станет после его чистки
+    void retire(DeviceId id) {
+        slots_[id].type = DeviceType::None;
+        ++slots_[id].generation;
+        retired_.push_back(id);
+    }
+
+    void releaseRetired() const {
+        free_.insert(free_.end(), retired_.begin(), retired_.end());
+        retired_.clear();
+    }
+
+    void compactOrder() const {
+        order_.erase(std::remove_if(order_.begin(), order_.end(), [&](DeviceId id) { return !contains(id); }),
+                     order_.end());
+        releaseRetired();
+    }
+
+    template <class Record>
+    void swapPop(std::vector<Record>& v, uint32_t index) {
+        if (index + 1 != v.size()) {
+            v[index] = v.back();
+            slots_[v[index].common.id].index = index;
+        }
+        v.pop_back();
+    }
+
+    // Сдвиг оставшихся к началу с сохранением порядка
+    template <class Record>
+    void compactRecords(std::vector<Record>& v, const std::vector<char>& gone) {
+        size_t kept = 0;
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (gone[v[i].common.id]) {
+                garbageApps_ += v[i].common.appsCount;
+                continue;
+            }
+            if (kept != i) v[kept] = v[i];
+            slots_[v[kept].common.id].index = static_cast<uint32_t>(kept);
+            ++kept;
+        }
+        v.resize(kept);
+    }
+
+    void compactApps() {
+        std::vector<uint32_t> packed;
+        packed.reserve(appList_.size() - garbageApps_);
+        auto move = [&](DeviceCommon& c) {
+            uint32_t begin = static_cast<uint32_t>(packed.size());
+            packed.insert(packed.end(), appList_.begin() + c.appsBegin, appList_.begin() + c.appsBegin + c.appsCount);
+            c.appsBegin = begin;
+        };
+        for (PhoneRecord& p : phones_) move(p.common);
+        for (LaptopRecord& l : laptops_) move(l.common);
+        appList_.swap(packed);
+        garbageApps_ = 0;
+    }
+
+    std::vector<PhoneRecord> phones_;
+    std::vector<LaptopRecord> laptops_;
+    std::vector<Slot> slots_;       // по DeviceId
+    // order() чистит удалённые и из const: состояние, видимое снаружи, то же
+    mutable std::vector<DeviceId> order_;
+    mutable std::vector<DeviceId> retired_, free_;
+    std::vector<uint32_t> appList_;
+    size_t garbageApps_ = 0;
+    StringPool brands_, models_, oses_, appNames_;
+    DeviceIndex index_;
+    SortedKeys brandPrice_;           // (место бренда, цена по убыванию)
+    std::vector<uint32_t> brandRank_;
+    TextIndex text_;                  // значение - номер в searchTerms_
+    std::vector<SearchTerm> searchTerms_;
+    uint32_t searchedBrands_ = 0, searchedModels_ = 0, searchedApps_ = 0;
+};
@@ -0,0 +1,333 @@
+#pragma once
+
+// Вторичные индексы каталога устройств.
+// Бренд, ОС и приложение уже интернированы в плотные номера, поэтому
+// "хеш-индекс" - просто вектор списков по номеру строки. Список id - IdBitmap
+// в духе Roaring: id делятся по старшим 16 битам на блоки, блок хранит
+// младшие 16 бит либо отсортированным массивом (до kArrayMax штук), либо
+// битовой картой на 65536 бит. Пересечение и объединение идут блок за
+// блоком (массив-массив слиянием, карта-карта словами по 64 бита).
+// Цена - отсортированный массив ключей (SortedKeys): диапазон за O(log n + k).
+// id здесь - номер слота каталога: после удаления слот может достаться
+// новому устройству, поэтому списки остаются плотными.
+// Новые записи копятся отдельно и вливаются одним слиянием при запросе,
+// чтобы загрузка миллиона устройств не была миллионом вставок в середину.
+
+#include "device_sort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+class IdBitmap {
+public:
+    static constexpr uint32_t kArrayMax = 4096; // больше - выгоднее битовая карта (8 КБ)
+
+    void add(uint32_t id) {
+        Chunk& c = chunkFor(static_cast<uint16_t>(id >> 16));
+        uint16_t low = static_cast<uint16_t>(id);
+        if (c.isBitmap()) {
+            uint64_t& w = c.bits[low >> 6];
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (!(w & bit)) { w |= bit; ++c.card; ++size_; }
+            return;
+        }
+        auto it = std::lower_bound(c.array.begin(), c.array.end(), low);
+        if (it != c.array.end() && *it == low) return;
+        c.array.insert(it, low);
+        ++c.card;
+        ++size_;
+        if (c.card > kArrayMax) toBitmap(c);
+    }
+
+    void remove(uint32_t id) {
+        auto it = lowerBound(chunks_, static_cast<uint16_t>(id >> 16));
+        if (it == chunks_.end() || it->key != static_cast<uint16_t>(id >> 16)) return;
+        Chunk* c = &*it;
+        uint16_t low = static_cast<uint16_t>(id);
+        if (c->isBitmap()) {
+            uint64_t& w = c->bits[low >> 6];
+            uint64_t bit = uint64_t(1) << (low & 63);
+            if (!(w & bit)) return;
+            w &= ~bit;
+            --c->card;
+            if (c->card <= kArrayMax) toArray(*c);
+        } else {
+            auto pos = std::lower_bound(c->array.begin(), c->array.end(), low);
+            if (pos == c->array.end() || *pos != low) return;
+            c->array.erase(pos);
+            --c->card;
+        }
+        --size_;
+        if (c->card == 0) chunks_.erase(chunks_.begin() + (c - chunks_.data()));
+    }
+
+    bool contains(uint32_t id) const {
+        auto it = lowerBound(chunks_, static_cast<uint16_t>(id >> 16));
+        if (it == chunks_.end() || it->key != static_cast<uint16_t>(id >> 16)) return false;
+        const Chunk* c = &*it;
+        uint16_t low = static_cast<uint16_t>(id);
+        if (c->isBitmap()) return c->bits[low >> 6] >> (low & 63) & 1;
+        return std::binary_search(c->array.begin(), c->array.end(), low);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Обход по возрастанию id
+    template <class F>
+    void forEach(F&& f) const {
+        for (const Chunk& c : chunks_) {
+            uint32_t high = uint32_t(c.key) << 16;
+            if (!c.isBitmap()) {
+                for (uint16_t low : c.array) f(high | low);
+                continue;
+            }
+            for (uint32_t w = 0; w < kWords; ++w)
+                for (uint64_t bits = c.bits[w]; bits; bits &= bits - 1)
+                    f(high | (w << 6) | static_cast<uint32_t>(__builtin_ctzll(bits)));
+        }
+    }
+
+    // То же с остановкой: f(id) -> продолжать ли
+    template <class F>
+    bool forEachWhile(F&& f) const {
+        for (const Chunk& c : chunks_) {
+            uint32_t high = uint32_t(c.key) << 16;
+            if (!c.isBitmap()) {
+                for (uint16_t low : c.array)
+                    if (!f(high | low)) return false;
+                continue;
+            }
+            for (uint32_t w = 0; w < kWords; ++w)
+                for (uint64_t bits = c.bits[w]; bits; bits &= bits - 1)
+                    if (!f(high | (w << 6) | static_cast<uint32_t>(__builtin_ctzll(bits)))) return false;
+        }
+        return true;
+    }
+
+    std::vector<uint32_t> toVector() const {
+        std::vector<uint32_t> out;
+        out.reserve(size_);
+        forEach([&](uint32_t id) { out.push_back(id); });
+        return out;
+    }
+
+    static IdBitmap intersect(const IdBitmap& a, const IdBitmap& b) {
+        IdBitmap r;
+        size_t i = 0, j = 0;
+        while (i < a.chunks_.size() && j < b.chunks_.size()) {
+            const Chunk& x = a.chunks_[i];
+            const Chunk& y = b.chunks_[j];
+            if (x.key < y.key) { ++i; continue; }
+            if (y.key < x.key) { ++j; continue; }
+            Chunk c;
+            c.key = x.key;
+            if (x.isBitmap() && y.isBitmap()) {
+                c.bits.resize(kWords);
+                for (uint32_t w = 0; w < kWords; ++w) {
+                    c.bits[w] = x.bits[w] & y.bits[w];
+                    c.card += static_cast<uint32_t>(__builtin_popcountll(c.bits[w]));
+                }
+                if (c.card <= kArrayMax) toArray(c);
+            } else if (x.isBitmap() || y.isBitmap()) {
+                const Chunk& arr = x.isBitmap() ? y : x;
+                const Chunk& map = x.isBitmap() ? x : y;
+                for (uint16_t low : arr.array)
+                    if (map.bits[low >> 6] >> (low & 63) & 1) c.array.push_back(low);
+                c.card = static_cast<uint32_t>(c.array.size());
+            } else {
+                std::set_intersection(x.array.begin(), x.array.end(), y.array.begin(), y.array.end(),
+                                      std::back_inserter(c.array));
+                c.card = static_cast<uint32_t>(c.array.size());
+            }
+            if (c.card) {
+                r.size_ += c.card;
+                r.chunks_.push_back(std::move(c));
+            }
+            ++i;
+            ++j;
+        }
+        return r;
+    }
+
+    static IdBitmap unite(const IdBitmap& a, const IdBitmap& b) {
+        IdBitmap r;
+        size_t i = 0, j = 0;
+        while (i < a.chunks_.size() || j < b.chunks_.size()) {
+            if (j == b.chunks_.size() || (i < a.chunks_.size() && a.chunks_[i].key < b.chunks_[j].key)) {
+                r.chunks_.push_back(a.chunks_[i++]);
+            } else if (i == a.chunks_.size() || b.chunks_[j].key < a.chunks_[i].key) {
+                r.chunks_.push_back(b.chunks_[j++]);
+            } else {
+                const Chunk& x = a.chunks_[i++];
+                const Chunk& y = b.chunks_[j++];
+                Chunk c;
+                c.key = x.key;
+                if (!x.isBitmap() && !y.isBitmap() && x.card + y.card <= kArrayMax) {
+                    std::set_union(x.array.begin(), x.array.end(), y.array.begin(), y.array.end(),
+                                   std::back_inserter(c.array));
+                    c.card = static_cast<uint32_t>(c.array.size());
+                } else {
+                    c.bits.assign(kWords, 0);
+                    for (const Chunk* s : {&x, &y}) {
+                        if (s->isBitmap())
+                            for (uint32_t w = 0; w < kWords; ++w) c.bits[w] |= s->bits[w];
+                        else
+                            for (uint16_t low : s->array) c.bits[low >> 6] |= uint64_t(1) << (low & 63);
+                    }
+                    for (uint64_t w : c.bits) c.card += static_cast<uint32_t>(__builtin_popcountll(w));
+                    if (c.card <= kArrayMax) toArray(c);
+                }
+                r.chunks_.push_back(std::move(c));
+            }
+            r.size_ += r.chunks_.back().card;
+        }
+        return r;
+    }
+
+private:
+    static constexpr uint32_t kWords = 65536 / 64;
+
+    struct Chunk {
+        uint16_t key = 0;               // старшие 16 бит id
+        uint32_t card = 0;
+        std::vector<uint16_t> array;    // отсортированные младшие 16 бит
+        std::vector<uint64_t> bits;     // или битовая карта (kWords слов)
+        bool isBitmap() const { return !bits.empty(); }
+    };
+
+    template <class Chunks>
+    static auto lowerBound(Chunks& chunks, uint16_t key) -> decltype(chunks.begin()) {
+        return std::lower_bound(chunks.begin(), chunks.end(), key,
+                                [](const Chunk& c, uint16_t k) { return c.key < k; });
+    }
+
+    Chunk& chunkFor(uint16_t key) {
+        auto it = lowerBound(chunks_, key);
+        if (it == chunks_.end() || it->key != key) {
+            it = chunks_.insert(it, Chunk());
+            it->key = key;
+        }
+        return *it;
+    }
+
+    static void toBitmap(Chunk& c) {
+        c.bits.assign(kWords, 0);
+        for (uint16_t low : c.array) c.bits[low >> 6] |= uint64_t(1) << (low & 63);
+        std::vector<uint16_t>().swap(c.array);
+    }
+
+    static void toArray(Chunk& c) {
+        c.array.clear();
+        c.array.reserve(c.card);
+        for (uint32_t w = 0; w < kWords; ++w)
+            for (uint64_t bits = c.bits[w]; bits; bits &= bits - 1)
+                c.array.push_back(static_cast<uint16_t>((w << 6) | static_cast<uint32_t>(__builtin_ctzll(bits))));
+        std::vector<uint64_t>().swap(c.bits);
+    }
+
+    std::vector<Chunk> chunks_;
+    size_t size_ = 0;
+};
+
+// Упорядоченный индекс (цена, id)
+class PriceIndex {
+public:
+    void add(uint32_t id, double price) { keys_.add(SortKey{priceKey(price), 0, id}); }
+    void remove(uint32_t id, double price) { keys_.remove(SortKey{priceKey(price), 0, id}); }
+
+    void update(uint32_t id, double oldPrice, double newPrice) {
+        remove(id, oldPrice);
+        add(id, newPrice);
+    }
+
+    template <class Dead>
+    size_t removeIf(Dead dead) { return keys_.removeIf(dead); }
+
+    // id с ценой в (lo, hi], по возрастанию цены
+    template <class F>
+    void forRange(double lo, double hi, F&& f) {
+        const std::vector<SortKey>& k = keys_.keys();
+        uint64_t last = priceKey(hi);
+        for (auto it = std::upper_bound(k.begin(), k.end(), SortKey{priceKey(lo), 0, 0}); it != k.end() && it->lo <= last; ++it)
+            f(it->id);
+    }
+
+    // Сколько цен больше lo - без обхода, O(log n)
+    size_t countAbove(double lo) {
+        const std::vector<SortKey>& k = keys_.keys();
+        return static_cast<size_t>(k.end() - std::upper_bound(k.begin(), k.end(), SortKey{priceKey(lo), 0, 0}));
+    }
+
+    // Все id по возрастанию цены, при равной цене - в порядке добавления (или смены цены)
+    const std::vector<SortKey>& sorted() { return keys_.keys(); }
+
+    size_t size() const { return keys_.size(); }
+
+    // Влить накопленные добавления (запросы делают это сами)
+    void flush() { keys_.flush(); }
+
+private:
+    SortedKeys keys_;
+};
+
+// Индексы каталога: бренд, модель, ОС (только смартфоны), приложения, цена
+class DeviceIndex {
+public:
+    static constexpr uint32_t kNoOs = UINT32_MAX;
+
+    void add(uint32_t id, uint32_t brand, uint32_t model, uint32_t os, double price, const uint32_t* apps,
+             uint32_t appCount) {
+        listFor(brands_, brand).add(id);
+        listFor(models_, model).add(id);
+        if (os != kNoOs) listFor(oses_, os).add(id);
+        for (uint32_t i = 0; i < appCount; ++i) listFor(apps_, apps[i]).add(id);
+        price_.add(id, price);
+    }
+
+    void remove(uint32_t id, uint32_t brand, uint32_t model, uint32_t os, double price, const uint32_t* apps,
+                uint32_t appCount) {
+        removeFromLists(id, brand, model, os, apps, appCount);
+        price_.remove(id, price);
+    }
+
+    // Без индекса цен: при удалении многих id цены чистятся одним проходом (price().removeIf)
+    void removeFromLists(uint32_t id, uint32_t brand, uint32_t model, uint32_t os, const uint32_t* apps,
+                         uint32_t appCount) {
+        listFor(brands_, brand).remove(id);
+        listFor(models_, model).remove(id);
+        if (os != kNoOs) listFor(oses_, os).remove(id);
+        for (uint32_t i = 0; i < appCount; ++i) listFor(apps_, apps[i]).remove(id);
+    }
+
+    void addApp(uint32_t id, uint32_t app) { listFor(apps_, app).add(id); }
+    void updateModel(uint32_t id, uint32_t oldModel, uint32_t newModel) {
+        listFor(models_, oldModel).remove(id);
+        listFor(models_, newModel).add(id);
+    }
+    void updatePrice(uint32_t id, double oldPrice, double newPrice) { price_.update(id, oldPrice, newPrice); }
+
+    // Пустой список, если такого бренда / модели / ОС / приложения нет
+    const IdBitmap& byBrand(uint32_t brand) const { return get(brands_, brand); }
+    const IdBitmap& byModel(uint32_t model) const { return get(models_, model); }
+    const IdBitmap& byOs(uint32_t os) const { return get(oses_, os); }
+    const IdBitmap& byApp(uint32_t app) const { return get(apps_, app); }
+    PriceIndex& price() { return price_; }
+
+private:
+    static IdBitmap& listFor(std::vector<IdBitmap>& v, uint32_t key) {
+        if (key >= v.size()) v.resize(key + 1);
+        return v[key];
+    }
+
+    static const IdBitmap& get(const std::vector<IdBitmap>& v, uint32_t key) {
+        static const IdBitmap empty;
+        return key < v.size() ? v[key] : empty;
+    }
+
+    std::vector<IdBitmap> brands_, models_, oses_, apps_;
+    PriceIndex price_;
+};
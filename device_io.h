@@ -0,0 +1,306 @@
+#pragma once
+
+// Загрузка и сохранение каталога устройств.
+// Текст (devices.txt): файл отображается в память (mmap), делится на куски
+// по границам строк, куски разбираются параллельно - каждый поток в свой
+// DeviceBatch со своими пулами строк, затем пакеты по порядку переносятся в
+// каталог. Сохранение - тоже по кускам order() в строковые буферы, затем
+// один проход fwrite.
+// Бинарный формат (.bin): заголовок с версией и CRC32C данных, затем
+// массивы записей DeviceBatch::Item, номеров приложений и четыре пула строк
+// (число строк, концы строк, символы). Пишется и читается целыми массивами.
+// Порядок байт и выравнивание - родные, файл не переносится между платформами.
+
+#include "crc32c.h"
+#include "csv_reader.h"
+#include "device_catalog.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Разбор строки devices.txt: тип;бренд;модель;цена;параметр;приложения
+// (параметр: "ОС-память" у смартфона, "экран-батарея" у ноутбука).
+// false - тип не распознан, строка пропускается, как в loadFromFile.
+inline bool parseDeviceLine(std::string_view line, DeviceBatch& batch) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    auto field = [&line](char sep) {
+        size_t p = line.find(sep);
+        std::string_view f = line.substr(0, p);
+        line.remove_prefix(p == std::string_view::npos ? line.size() : p + 1);
+        return f;
+    };
+    std::string_view type = field(';'), brand = field(';'), model = field(';'), priceStr = field(';'),
+                     param = field(';');
+    DeviceBatch::Item it{};
+    if (type == "Smartphone") it.type = DeviceType::Smartphone;
+    else if (type == "Laptop") it.type = DeviceType::Laptop;
+    else return false;
+
+    parseDouble(priceStr, it.price);
+    it.brand = batch.brands.intern(brand);
+    it.model = batch.models.intern(model);
+    it.appsBegin = static_cast<uint32_t>(batch.apps.size());
+    while (!line.empty()) batch.apps.push_back(batch.appNames.intern(field('|')));
+    it.appsCount = static_cast<uint32_t>(batch.apps.size()) - it.appsBegin;
+
+    size_t dash = param.find('-');
+    std::string_view left = param.substr(0, dash);
+    std::string_view right = dash == std::string_view::npos ? std::string_view() : param.substr(dash + 1);
+    if (it.type == DeviceType::Smartphone) {
+        it.os = batch.oses.intern(left);
+        parseInt(right, it.memory);
+    } else {
+        parseDouble(left, it.screen);
+        parseInt(right, it.battery);
+    }
+    batch.items.push_back(it);
+    return true;
+}
+
+// Куски data по границам строк, не мельче minBytes
+inline std::vector<std::string_view> splitLines(std::string_view data, size_t parts, size_t minBytes = 1 << 20) {
+    parts = std::max<size_t>(1, std::min(parts, data.size() / minBytes));
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (size_t k = 1; k <= parts && begin < data.size(); ++k) {
+        size_t end = k == parts ? data.size() : std::max(begin, data.size() / parts * k);
+        if (end < data.size()) {
+            end = data.find('\n', end);
+            end = end == std::string_view::npos ? data.size() : end + 1;
+        }
+        chunks.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+// threads = 0 - по числу ядер
+inline bool loadCatalogText(const std::string& filename, DeviceCatalog& catalog, unsigned threads = 0) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string_view> chunks = splitLines(file.view(), threads);
+    std::vector<DeviceBatch> batches(chunks.size());
+    auto parse = [&](size_t k) {
+        std::string_view data = chunks[k];
+        // Строка devices.txt в среднем длиннее 40 байт - с запасом
+        batches[k].items.reserve(data.size() / 40);
+        while (!data.empty()) {
+            size_t nl = data.find('\n');
+            parseDeviceLine(data.substr(0, nl), batches[k]);
+            data.remove_prefix(nl == std::string_view::npos ? data.size() : nl + 1);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t k = 1; k < chunks.size(); ++k) workers.emplace_back(parse, k);
+    if (!chunks.empty()) parse(0);
+    for (std::thread& t : workers) t.join();
+
+    size_t phones = 0, total = catalog.size();
+    for (const DeviceBatch& b : batches) {
+        total += b.items.size();
+        for (const DeviceBatch::Item& it : b.items) phones += it.type == DeviceType::Smartphone;
+    }
+    catalog.reserve(catalog.phones().size() + phones, total - catalog.phones().size() - phones);
+    for (const DeviceBatch& b : batches) catalog.append(b);
+    catalog.index().price().flush();
+    std::cout << "Data loaded from " << filename << std::endl;
+    return true;
+}
+
+inline bool saveCatalogText(const std::string& filename, const DeviceCatalog& catalog, unsigned threads = 0) {
+    std::FILE* out = std::fopen(filename.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Cannot open file for writing: " << filename << std::endl;
+        return false;
+    }
+    const std::vector<DeviceId>& order = catalog.order();
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // Меньше 64K устройств на поток - потоки дороже самой работы
+    size_t parts = std::max<size_t>(1, std::min<size_t>(threads, order.size() / 65536));
+    std::vector<std::string> buffers(parts);
+    auto format = [&](size_t k) {
+        size_t begin = order.size() * k / parts, end = order.size() * (k + 1) / parts;
+        buffers[k].reserve((end - begin) * 64);
+        for (size_t i = begin; i < end; ++i) catalog.appendText(order[i], buffers[k]);
+    };
+    std::vector<std::thread> workers;
+    for (size_t k = 1; k < parts; ++k) workers.emplace_back(format, k);
+    format(0);
+    for (std::thread& t : workers) t.join();
+
+    bool ok = true;
+    for (const std::string& b : buffers) ok = ok && std::fwrite(b.data(), 1, b.size(), out) == b.size();
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Cannot write file: " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Data saved to " << filename << std::endl;
+    return true;
+}
+
+constexpr char kCatalogMagic[8] = {'D', 'E', 'V', 'C', 'A', 'T', 'B', 'N'};
+constexpr uint32_t kCatalogVersion = 1;
+
+struct CatalogFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t crc;        // CRC32C всего, что после заголовка
+    uint64_t items, apps;
+    uint64_t strings[4]; // brands, models, oses, appNames
+    uint64_t chars[4];
+};
+
+inline bool isBinaryCatalogName(const std::string& filename) {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0;
+}
+
+inline bool saveCatalogBinary(const std::string& filename, const DeviceCatalog& catalog) {
+    // Устройства в порядке показа; номера строк - прямо номера пулов каталога
+    std::vector<DeviceBatch::Item> items;
+    std::vector<uint32_t> apps;
+    items.reserve(catalog.size());
+    for (DeviceId id : catalog.order()) {
+        const DeviceCommon& c = catalog.common(id);
+        DeviceBatch::Item it;
+        std::memset(&it, 0, sizeof(it));  // и выравнивающие байты: одинаковый каталог - одинаковый файл
+        it.type = catalog.type(id);
+        it.brand = c.brand;
+        it.model = c.model;
+        it.appsBegin = static_cast<uint32_t>(apps.size());
+        it.appsCount = c.appsCount;
+        it.price = c.price;
+        apps.insert(apps.end(), catalog.apps(c), catalog.apps(c) + c.appsCount);
+        if (it.type == DeviceType::Smartphone) {
+            it.os = catalog.phone(id).os;
+            it.memory = catalog.phone(id).memory;
+        } else {
+            it.screen = catalog.laptop(id).screen;
+            it.battery = catalog.laptop(id).battery;
+        }
+        items.push_back(it);
+    }
+
+    const StringPool* pools[4] = {&catalog.brands(), &catalog.models(), &catalog.oses(), &catalog.appNames()};
+    struct Blob { const void* data; size_t size; };
+    std::vector<Blob> blobs = {{items.data(), items.size() * sizeof(DeviceBatch::Item)},
+                               {apps.data(), apps.size() * sizeof(uint32_t)}};
+    CatalogFileHeader header{};
+    std::memcpy(header.magic, kCatalogMagic, sizeof(header.magic));
+    header.version = kCatalogVersion;
+    header.items = items.size();
+    header.apps = apps.size();
+    for (int p = 0; p < 4; ++p) {
+        header.strings[p] = pools[p]->count();
+        header.chars[p] = pools[p]->chars().size();
+        blobs.push_back({pools[p]->ends().data(), pools[p]->ends().size() * sizeof(uint32_t)});
+        blobs.push_back({pools[p]->chars().data(), pools[p]->chars().size()});
+    }
+    for (const Blob& b : blobs) header.crc = crc32c(b.data, b.size, header.crc);
+
+    // Через временный файл: прерванная запись не портит прежний каталог
+    std::string tmp = filename + ".tmp";
+    std::FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Cannot open file for writing: " << filename << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+    for (const Blob& b : blobs) ok = ok && std::fwrite(b.data, 1, b.size, out) == b.size;
+    ok = std::fclose(out) == 0 && ok;
+    if (ok) ok = std::rename(tmp.c_str(), filename.c_str()) == 0;
+    if (!ok) {
+        std::remove(tmp.c_str());
+        std::cerr << "Cannot write file: " << filename << std::endl;
+        return false;
+    }
+    std::cout << "Data saved to " << filename << std::endl;
+    return true;
+}
+
+inline bool loadCatalogBinary(const std::string& filename, DeviceCatalog& catalog) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Cannot open file: " << filename << std::endl;
+        return false;
+    }
+    auto fail = [&](const char* why) {
+        std::cerr << "Bad catalog file " << filename << ": " << why << std::endl;
+        return false;
+    };
+    CatalogFileHeader header;
+    if (file.size() < sizeof(header)) return fail("too short");
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kCatalogMagic, sizeof(header.magic)) != 0) return fail("not a catalog");
+    if (header.version != kCatalogVersion) return fail("unsupported version");
+
+    // Каждый счётчик не больше, чем помещается в файл, - тогда сумма ниже не переполняется
+    uint64_t body = file.size() - sizeof(header);
+    bool fits = header.items <= body / sizeof(DeviceBatch::Item) && header.apps <= body / sizeof(uint32_t);
+    for (int p = 0; p < 4; ++p) fits = fits && header.strings[p] <= body / sizeof(uint32_t) && header.chars[p] <= body;
+    if (!fits) return fail("size mismatch");
+    uint64_t need = header.items * sizeof(DeviceBatch::Item) + header.apps * sizeof(uint32_t);
+    for (int p = 0; p < 4; ++p) need += header.strings[p] * sizeof(uint32_t) + header.chars[p];
+    if (body != need) return fail("size mismatch");
+    const char* pos = file.data() + sizeof(header);
+    if (crc32c(pos, need) != header.crc) return fail("checksum mismatch");
+
+    DeviceBatch batch;
+    batch.items.resize(header.items);
+    std::memcpy(batch.items.data(), pos, header.items * sizeof(DeviceBatch::Item));
+    pos += header.items * sizeof(DeviceBatch::Item);
+    batch.apps.resize(header.apps);
+    std::memcpy(batch.apps.data(), pos, header.apps * sizeof(uint32_t));
+    pos += header.apps * sizeof(uint32_t);
+
+    StringPool* pools[4] = {&batch.brands, &batch.models, &batch.oses, &batch.appNames};
+    for (int p = 0; p < 4; ++p) {
+        std::vector<uint32_t> ends(header.strings[p]);
+        std::memcpy(ends.data(), pos, ends.size() * sizeof(uint32_t));
+        pos += ends.size() * sizeof(uint32_t);
+        uint32_t begin = 0;
+        for (uint32_t end : ends) {
+            if (end < begin || end > header.chars[p]) return fail("bad string table");
+            pools[p]->intern(std::string_view(pos + begin, end - begin));
+            begin = end;
+        }
+        // Повторы в пуле сдвинули бы номера строк, на которые ссылаются записи
+        if (pools[p]->count() != header.strings[p]) return fail("duplicate strings");
+        pos += header.chars[p];
+    }
+    // Номера строк в записях должны попадать в пулы
+    for (const DeviceBatch::Item& it : batch.items) {
+        bool phone = it.type == DeviceType::Smartphone;
+        if ((!phone && it.type != DeviceType::Laptop) || it.brand >= header.strings[0] ||
+            it.model >= header.strings[1] || (phone && it.os >= header.strings[2]) ||
+            uint64_t(it.appsBegin) + it.appsCount > header.apps)
+            return fail("bad device record");
+    }
+    for (uint32_t a : batch.apps)
+        if (a >= header.strings[3]) return fail("bad app reference");
+
+    catalog.append(batch);
+    catalog.index().price().flush();
+    std::cout << "Data loaded from " << filename << std::endl;
+    return true;
+}
+
+// Формат по имени файла: *.bin - бинарный, иначе текст devices.txt
+inline bool loadCatalog(const std::string& filename, DeviceCatalog& catalog) {
+    return isBinaryCatalogName(filename) ? loadCatalogBinary(filename, catalog) : loadCatalogText(filename, catalog);
+}
+
+inline bool saveCatalog(const std::string& filename, const DeviceCatalog& catalog) {
+    return isBinaryCatalogName(filename) ? saveCatalogBinary(filename, catalog) : saveCatalogText(filename, catalog);
+}
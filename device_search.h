@@ -0,0 +1,327 @@
+#pragma once
+
+// Текстовый поиск по названиям: префиксный (автодополнение) и с опечатками.
+// Ключ - название в нижнем регистре (ASCII), а также каждое его слово
+// ("iPhone 15" -> "iphone 15", "iphone", "15"), поэтому находится и
+// часть модели. Ключи интернированы (StringPool), у ключа - список
+// значений (номеров терминов вызывающей стороны).
+// Префикс - сжатое префиксное дерево (radix tree): дуга хранит кусок
+// ключа, узел с одним потомком не заводится. Продолжения префикса
+// выдаются от коротких к длинным обходом с приоритетом по длине, поэтому
+// лимит не требует обходить всё поддерево.
+// Опечатки - индекс триграмм ключа (с двумя пробелами по краям). Каждая
+// правка портит не больше трёх триграмм, поэтому ключ на расстоянии
+// Левенштейна <= k делит с запросом не меньше G - 3k из его G различных
+// триграмм и встречается хотя бы в одном из 3k + 1 самых коротких их
+// списков: кандидаты берутся только оттуда и проверяются расчётом
+// расстояния с отсечкой. Если и эти списки длинные (у ключей общее
+// начало вроде "model-" и мало редких триграмм) или запрос слишком
+// короток для фильтра, ключи ищутся обходом дерева со строками таблицы
+// Левенштейна: общее начало считается один раз, ветка бросается, как
+// только все её продолжения заведомо дальше k.
+// Значения добавляются по возрастанию. Индекс только растёт: значение, которое больше не нужно (у термина не
+// осталось устройств), отбрасывает фильтр accept при поиске.
+
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+enum class MatchKind : uint8_t { Exact, Prefix, Fuzzy };
+
+inline std::string foldCase(std::string_view s) {
+    std::string out(s);
+    for (char& c : out)
+        if (c >= 'A' && c <= 'Z') c = char(c - 'A' + 'a');
+    return out;
+}
+
+// Расстояние Левенштейна, но не больше limit + 1 (дальше не считается).
+// Строки названий короткие: строки таблицы - на стеке, длинные - в куче.
+inline uint32_t boundedEditDistance(std::string_view a, std::string_view b, uint32_t limit) {
+    if (a.size() > b.size()) std::swap(a, b);
+    if (b.size() - a.size() > limit) return limit + 1;
+    uint32_t local[2][64];
+    std::vector<uint32_t> heap;
+    uint32_t *prev = local[0], *cur = local[1];
+    if (a.size() >= 64) {
+        heap.resize(2 * (a.size() + 1));
+        prev = heap.data();
+        cur = prev + a.size() + 1;
+    }
+    for (uint32_t i = 0; i <= a.size(); ++i) prev[i] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+        cur[0] = static_cast<uint32_t>(j);
+        uint32_t best = cur[0];
+        for (size_t i = 1; i <= a.size(); ++i) {
+            cur[i] = std::min({prev[i] + 1, cur[i - 1] + 1, prev[i - 1] + (a[i - 1] != b[j - 1])});
+            best = std::min(best, cur[i]);
+        }
+        if (best > limit) return limit + 1;
+        std::swap(prev, cur);
+    }
+    return std::min(prev[a.size()], limit + 1);
+}
+
+class TextIndex {
+public:
+    TextIndex() { nodes_.push_back(Node{}); }
+
+    // Название text со значением value: сам text и каждое его слово
+    void add(std::string_view text, uint32_t value) {
+        std::string key = foldCase(text);
+        addKey(key, value);
+        size_t begin = 0;
+        for (size_t i = 0; i <= key.size(); ++i) {
+            if (i < key.size() && !isSeparator(key[i])) continue;
+            if (i > begin && i - begin < key.size()) addKey(std::string_view(key).substr(begin, i - begin), value);
+            begin = i + 1;
+        }
+    }
+
+    // Допустимое число опечаток для запроса длины len: 0-2 символа - без
+    // опечаток, 3-5 - одна, дальше - две
+    static uint32_t typoLimit(size_t len) { return len < 3 ? 0 : len < 6 ? 1 : 2; }
+
+    // Значения, совпавшие с query, от лучших к худшим: точные совпадения,
+    // продолжения префикса (короткие раньше), затем ключи с опечатками (по
+    // числу опечаток). f(value, kind, distance) -> продолжать ли; значение
+    // выдаётся один раз - с лучшим совпадением, а до опечаток дело доходит,
+    // только если f не остановил поиск раньше.
+    template <class F>
+    void find(std::string_view query, F f) const {
+        std::string q = foldCase(query);
+        if (q.empty()) return;
+        std::unordered_set<uint32_t> seen;
+        auto emit = [&](uint32_t key, MatchKind kind, uint32_t distance) {
+            for (uint32_t v : values_[key])
+                if (seen.insert(v).second && !f(v, kind, distance)) return false;
+            return true;
+        };
+        bool more = true;
+        completions(q, [&](uint32_t key, uint32_t added) {
+            return more = emit(key, added ? MatchKind::Prefix : MatchKind::Exact, added);
+        });
+        uint32_t k = typoLimit(q.size());
+        if (!more || !k) return;
+        for (const auto& m : fuzzyMatches(q, k))
+            if (!emit(m.second, MatchKind::Fuzzy, m.first)) return;
+    }
+
+    size_t keyCount() const { return keys_.count(); }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr size_t kMaxCandidates = 4096;  // больше - дешевле обход дерева
+
+    struct Node {
+        uint32_t labelBegin = 0, labelLen = 0;  // кусок ключа в keys_.chars()
+        uint32_t key = kNone;                   // ключ, который кончается здесь
+        std::vector<uint32_t> children;         // по первому символу дуги
+    };
+
+    static bool isSeparator(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return u < 0x80 && !((u >= '0' && u <= '9') || (u >= 'a' && u <= 'z'));
+    }
+
+    static uint32_t gram(std::string_view padded, size_t i) {
+        return uint32_t(uint8_t(padded[i])) << 16 | uint32_t(uint8_t(padded[i + 1])) << 8 | uint8_t(padded[i + 2]);
+    }
+
+    // Различные триграммы "  s  "
+    static std::vector<uint32_t> grams(std::string_view s) {
+        std::string padded = "  " + std::string(s) + "  ";
+        std::vector<uint32_t> g;
+        for (size_t i = 0; i + 3 <= padded.size(); ++i) g.push_back(gram(padded, i));
+        std::sort(g.begin(), g.end());
+        g.erase(std::unique(g.begin(), g.end()), g.end());
+        return g;
+    }
+
+    std::string_view label(const Node& n) const { return keys_.chars().substr(n.labelBegin, n.labelLen); }
+
+    // Потомок node, дуга которого начинается с c; kNone - нет
+    uint32_t child(uint32_t node, char c) const {
+        const std::vector<uint32_t>& ch = nodes_[node].children;
+        auto it = std::lower_bound(ch.begin(), ch.end(), c,
+                                   [&](uint32_t n, char x) { return label(nodes_[n])[0] < x; });
+        return it != ch.end() && label(nodes_[*it])[0] == c ? *it : kNone;
+    }
+
+    void addChild(uint32_t node, uint32_t n) {
+        std::vector<uint32_t>& ch = nodes_[node].children;
+        char c = label(nodes_[n])[0];
+        ch.insert(std::lower_bound(ch.begin(), ch.end(), c,
+                                   [&](uint32_t x, char v) { return label(nodes_[x])[0] < v; }),
+                  n);
+    }
+
+    void addKey(std::string_view text, uint32_t value) {
+        size_t before = keys_.count();
+        uint32_t key = keys_.intern(text);
+        if (key == before) {
+            values_.emplace_back();
+            insertTrie(key);
+            for (uint32_t g : grams(text)) grams_[g].push_back(key);
+        }
+        // Значения добавляются по возрастанию, повтор возможен только подряд
+        std::vector<uint32_t>& v = values_[key];
+        if (v.empty() || v.back() != value) v.push_back(value);
+    }
+
+    void insertTrie(uint32_t key) {
+        std::string_view s = keys_.name(key);
+        uint32_t base = key ? keys_.ends()[key - 1] : 0;
+        uint32_t node = 0;
+        size_t at = 0;
+        while (at < s.size()) {
+            uint32_t c = child(node, s[at]);
+            if (c == kNone) {
+                Node leaf;
+                leaf.labelBegin = base + static_cast<uint32_t>(at);
+                leaf.labelLen = static_cast<uint32_t>(s.size() - at);
+                leaf.key = key;
+                nodes_.push_back(leaf);
+                addChild(node, static_cast<uint32_t>(nodes_.size() - 1));
+                return;
+            }
+            std::string_view l = label(nodes_[c]);
+            size_t m = 0;
+            while (m < l.size() && at + m < s.size() && l[m] == s[at + m]) ++m;
+            if (m < l.size()) {
+                // Дуга расходится с ключом на m-м символе: делим её
+                Node mid;
+                mid.labelBegin = nodes_[c].labelBegin;
+                mid.labelLen = static_cast<uint32_t>(m);
+                mid.children.push_back(c);
+                nodes_[c].labelBegin += static_cast<uint32_t>(m);
+                nodes_[c].labelLen -= static_cast<uint32_t>(m);
+                nodes_.push_back(mid);
+                uint32_t id = static_cast<uint32_t>(nodes_.size() - 1);
+                std::vector<uint32_t>& ch = nodes_[node].children;
+                *std::find(ch.begin(), ch.end(), c) = id;
+                c = id;
+            }
+            node = c;
+            at += m;
+        }
+        nodes_[node].key = key;
+    }
+
+    // Ключи, начинающиеся с q, по возрастанию длины; f(key, added) -> продолжать ли
+    template <class F>
+    void completions(std::string_view q, F f) const {
+        uint32_t node = 0;
+        size_t at = 0, depth = 0;
+        while (at < q.size()) {
+            uint32_t c = child(node, q[at]);
+            if (c == kNone) return;
+            std::string_view l = label(nodes_[c]);
+            size_t m = 0;
+            while (m < l.size() && at + m < q.size() && l[m] == q[at + m]) ++m;
+            if (m < l.size() && at + m < q.size()) return;
+            node = c;
+            at += m;
+            depth = at - m + l.size();
+        }
+        using Item = std::tuple<size_t, uint32_t, uint32_t>;  // (длина, порядок, узел)
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        uint32_t seq = 0;
+        queue.push({depth, seq++, node});
+        while (!queue.empty()) {
+            size_t len = std::get<0>(queue.top());
+            uint32_t n = std::get<2>(queue.top());
+            queue.pop();
+            if (nodes_[n].key != kNone && !f(nodes_[n].key, static_cast<uint32_t>(len - q.size()))) return;
+            for (uint32_t c : nodes_[n].children) queue.push({len + nodes_[c].labelLen, seq++, c});
+        }
+    }
+
+    // Ключи на расстоянии 1..k от q: пары (расстояние, ключ) по возрастанию
+    std::vector<std::pair<uint32_t, uint32_t>> fuzzyMatches(std::string_view q, uint32_t k) const {
+        std::vector<std::pair<uint32_t, uint32_t>> out;
+        std::vector<uint32_t> candidates;
+        if (trigramCandidates(q, k, candidates)) {
+            for (uint32_t key : candidates) {
+                uint32_t d = boundedEditDistance(q, keys_.name(key), k);
+                if (d <= k && d > 0) out.push_back({d, key});
+            }
+        } else {
+            std::vector<uint32_t> rows(q.size() + 1);
+            for (uint32_t i = 0; i <= q.size(); ++i) rows[i] = i;
+            walkFuzzy(q, k, 0, 0, rows, out);
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    // Кандидаты из 3k + 1 самых коротких списков триграмм q; false - фильтр
+    // не работает (запрос короткий или кандидатов больше kMaxCandidates)
+    bool trigramCandidates(std::string_view q, uint32_t k, std::vector<uint32_t>& out) const {
+        std::vector<uint32_t> g = grams(q);
+        // Повторы триграмм схлопнуты, поэтому порог по различным: g.size() - 3k
+        if (g.size() <= 3 * k) return false;
+        static const std::vector<uint32_t> none;
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint32_t x : g) {
+            auto it = grams_.find(x);
+            lists.push_back(it != grams_.end() ? &it->second : &none);
+        }
+        std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+        lists.resize(3 * k + 1);
+        size_t total = 0;
+        for (auto* l : lists) total += l->size();
+        if (total > kMaxCandidates) return false;
+        for (auto* l : lists)
+            for (uint32_t key : *l) {
+                size_t len = keys_.name(key).size();
+                if (len + k >= q.size() && len <= q.size() + k) out.push_back(key);
+            }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return true;
+    }
+
+    // Потомки node; rows[depth] - строка таблицы для начала ключа длины depth
+    void walkFuzzy(std::string_view q, uint32_t k, uint32_t node, size_t depth, std::vector<uint32_t>& rows,
+                   std::vector<std::pair<uint32_t, uint32_t>>& out) const {
+        size_t w = q.size() + 1;
+        for (uint32_t c : nodes_[node].children) {
+            size_t d = depth;
+            bool alive = true;
+            for (char ch : label(nodes_[c])) {
+                if (rows.size() < (d + 2) * w) rows.resize((d + 2) * w);
+                const uint32_t* prev = &rows[d * w];
+                uint32_t* cur = &rows[(d + 1) * w];
+                cur[0] = static_cast<uint32_t>(d + 1);
+                uint32_t best = cur[0];
+                for (size_t i = 1; i < w; ++i) {
+                    cur[i] = std::min({prev[i] + 1, cur[i - 1] + 1, prev[i - 1] + (q[i - 1] != ch)});
+                    best = std::min(best, cur[i]);
+                }
+                ++d;
+                if (best > k) {
+                    alive = false;
+                    break;
+                }
+            }
+            if (!alive) continue;
+            uint32_t dist = rows[d * w + q.size()];
+            if (nodes_[c].key != kNone && dist <= k && dist > 0) out.push_back({dist, nodes_[c].key});
+            walkFuzzy(q, k, c, d, rows, out);
+        }
+    }
+
+    StringPool keys_;
+    std::vector<std::vector<uint32_t>> values_;             // по ключу
+    std::vector<Node> nodes_;                               // 0 - корень
+    std::unordered_map<uint32_t, std::vector<uint32_t>> grams_;  // триграмма -> ключи по возрастанию
+};
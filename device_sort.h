@@ -0,0 +1,182 @@
+#pragma once
+
+// Сортировка устройств по компактным ключам вместо самих записей.
+// Ключ - 16 байт: lo (цена в виде монотонного 64-битного числа), hi (место
+// бренда в алфавите или 0) и id устройства. Сортировка - LSD radix по байтам
+// ключа, устойчивая; разряд, одинаковый у всех ключей (старшие байты цен
+// из одного диапазона), пропускается. Каждый проход - подсчёт и раскладка
+// по кускам массива в нескольких потоках.
+// SortedKeys - заранее отсортированное представление: добавления копятся
+// отдельно и вливаются одним слиянием при следующем чтении, удалённый ключ
+// помечается на месте и вычищается одним проходом тогда же.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct SortKey {
+    uint64_t lo;
+    uint32_t hi;
+    uint32_t id;
+
+    // Порядок по (hi, lo); при равных ключах - порядок вставки
+    bool operator<(const SortKey& o) const { return hi < o.hi || (hi == o.hi && lo < o.lo); }
+};
+
+// Возрастающая цена -> возрастающее беззнаковое число (IEEE 754: у
+// отрицательных инвертируются все биты, у остальных - знаковый)
+inline uint64_t priceKey(double price) {
+    if (price == 0) price = 0;  // -0.0 и 0.0 - одна цена
+    uint64_t bits;
+    std::memcpy(&bits, &price, sizeof(bits));
+    return bits & (1ull << 63) ? ~bits : bits | (1ull << 63);
+}
+
+// Куски [0, n) для потоков: f(номер куска, from, to), первый - в текущем потоке
+template <class F>
+void forChunks(size_t n, unsigned parts, F&& f) {
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < parts; ++t)
+        pool.emplace_back([&f, n, parts, t] { f(t, n * t / parts, n * (t + 1) / parts); });
+    f(0u, size_t(0), n / parts);
+    for (std::thread& t : pool) t.join();
+}
+
+// Устойчивая сортировка по (hi, lo); threads = 0 - по числу ядер
+inline void radixSort(std::vector<SortKey>& keys, unsigned threads = 0) {
+    constexpr size_t kMinChunk = 1 << 16;  // мельче - std::stable_sort быстрее
+    constexpr int kDigits = 12;            // 8 байт lo, затем 4 байта hi
+    size_t n = keys.size();
+    if (n < kMinChunk) {
+        std::stable_sort(keys.begin(), keys.end());
+        return;
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, n / kMinChunk));
+
+    auto digit = [](const SortKey& k, int d) -> uint32_t {
+        return d < 8 ? static_cast<uint32_t>(k.lo >> (8 * d)) & 0xFF : (k.hi >> (8 * (d - 8))) & 0xFF;
+    };
+    // Какие разряды различаются: OR по XOR с первым ключом
+    std::vector<SortKey> differ(threads, SortKey{0, 0, 0});
+    const SortKey first = keys[0];
+    forChunks(n, threads, [&](unsigned part, size_t from, size_t to) {
+        SortKey d{0, 0, 0};
+        for (size_t i = from; i < to; ++i) {
+            d.lo |= keys[i].lo ^ first.lo;
+            d.hi |= keys[i].hi ^ first.hi;
+        }
+        differ[part] = d;
+    });
+    SortKey mask{0, 0, 0};
+    for (const SortKey& d : differ) {
+        mask.lo |= d.lo;
+        mask.hi |= d.hi;
+    }
+
+    std::vector<SortKey> buffer(n);
+    SortKey* src = keys.data();
+    SortKey* dst = buffer.data();
+    std::vector<std::array<size_t, 256>> counts(threads);
+    for (int d = 0; d < kDigits; ++d) {
+        if (digit(mask, d) == 0) continue;
+        forChunks(n, threads, [&](unsigned part, size_t from, size_t to) {
+            std::array<size_t, 256>& c = counts[part];
+            c.fill(0);
+            for (size_t i = from; i < to; ++i) ++c[digit(src[i], d)];
+        });
+        // Начало каждого (байт, поток): все меньшие байты, затем тот же байт у потоков раньше
+        size_t offset = 0;
+        for (size_t b = 0; b < 256; ++b) {
+            for (unsigned t = 0; t < threads; ++t) {
+                size_t c = counts[t][b];
+                counts[t][b] = offset;
+                offset += c;
+            }
+        }
+        forChunks(n, threads, [&](unsigned part, size_t from, size_t to) {
+            std::array<size_t, 256>& pos = counts[part];
+            for (size_t i = from; i < to; ++i) dst[pos[digit(src[i], d)]++] = src[i];
+        });
+        std::swap(src, dst);
+    }
+    if (src != keys.data()) keys.swap(buffer);
+}
+
+class SortedKeys {
+public:
+    // id удалённого ключа: порядок (hi, lo) не меняется, чтения его не видят
+    static constexpr uint32_t kDeadId = UINT32_MAX;
+
+    void add(const SortKey& k) { pending_.push_back(k); }
+
+    // Ключ ищется по (hi, lo), среди равных - по id. O(log n): в массиве
+    // ключ только помечается, сдвига нет
+    bool remove(const SortKey& k) {
+        if (pending_.size() > kPendingScan) flush();
+        for (size_t i = pending_.size(); i-- > 0;) {
+            if (pending_[i].id == k.id && pending_[i].hi == k.hi && pending_[i].lo == k.lo) {
+                pending_.erase(pending_.begin() + static_cast<std::ptrdiff_t>(i));
+                return true;
+            }
+        }
+        auto range = std::equal_range(sorted_.begin(), sorted_.end(), k);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->id == k.id) {
+                it->id = kDeadId;
+                ++dead_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Удалить все ключи, id которых подходит под dead(id), одним проходом
+    template <class Dead>
+    size_t removeIf(Dead dead) {
+        size_t before = size();
+        auto gone = [&](const SortKey& k) { return k.id == kDeadId || dead(k.id); };
+        sorted_.erase(std::remove_if(sorted_.begin(), sorted_.end(), gone), sorted_.end());
+        pending_.erase(std::remove_if(pending_.begin(), pending_.end(), gone), pending_.end());
+        dead_ = 0;
+        return before - size();
+    }
+
+    void clear() {
+        sorted_.clear();
+        pending_.clear();
+        dead_ = 0;
+    }
+
+    // Влить накопленные добавления (чтения делают это сами)
+    void flush() {
+        if (pending_.empty()) return;
+        radixSort(pending_);
+        size_t mid = sorted_.size();
+        sorted_.insert(sorted_.end(), pending_.begin(), pending_.end());
+        std::inplace_merge(sorted_.begin(), sorted_.begin() + static_cast<std::ptrdiff_t>(mid), sorted_.end());
+        pending_.clear();
+    }
+
+    const std::vector<SortKey>& keys() {
+        flush();
+        if (dead_) {
+            sorted_.erase(std::remove_if(sorted_.begin(), sorted_.end(),
+                                         [](const SortKey& k) { return k.id == kDeadId; }),
+                          sorted_.end());
+            dead_ = 0;
+        }
+        return sorted_;
+    }
+
+    size_t size() const { return sorted_.size() + pending_.size() - dead_; }
+
+private:
+    static constexpr size_t kPendingScan = 64;  // дольше искать в невлитых, чем влить их
+
+    std::vector<SortKey> sorted_, pending_;
+    size_t dead_ = 0;
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+// Встроенный колоночный движок для звезды sales_fact / products_dim / customers_dim.
+// Факты хранятся столбцами (struct-of-arrays), измерения - плотными массивами
+// по id. Группировка идёт в несколько потоков: для малого числа групп -
+// векторизуемые проходы с маской по блоку, иначе - разброс по аккумуляторам.
+// Суммы считаются в копейках (int64), поэтому точны и не зависят от порядка.
+
+#include "date_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Словарь строк: строка <-> плотный код
+class StringDict {
+public:
+    uint32_t intern(std::string_view s) {
+        auto it = codes_.find(std::string(s));
+        if (it != codes_.end()) return it->second;
+        uint32_t code = static_cast<uint32_t>(names_.size());
+        names_.emplace_back(s);
+        codes_.emplace(names_.back(), code);
+        return code;
+    }
+
+    const std::string& name(uint32_t code) const { return names_[code]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint32_t> codes_;
+};
+
+// id измерения -> код атрибута. Плотный массив, пока id не слишком разрежены.
+class DenseLookup {
+public:
+    static constexpr uint32_t kMissing = UINT32_MAX;
+
+    void set(int id, uint32_t code) {
+        if (id >= 0 && static_cast<size_t>(id) < kDenseLimit) {
+            if (static_cast<size_t>(id) >= dense_.size()) dense_.resize(static_cast<size_t>(id) + 1, kMissing);
+            dense_[static_cast<size_t>(id)] = code;
+        } else {
+            sparse_[id] = code;
+        }
+    }
+
+    uint32_t get(int id) const {
+        if (id >= 0 && static_cast<size_t>(id) < dense_.size()) return dense_[static_cast<size_t>(id)];
+        if (sparse_.empty()) return kMissing;
+        auto it = sparse_.find(id);
+        return it == sparse_.end() ? kMissing : it->second;
+    }
+
+private:
+    static constexpr size_t kDenseLimit = size_t(1) << 26;
+    std::vector<uint32_t> dense_;
+    std::unordered_map<int, uint32_t> sparse_;
+};
+
+struct SalesColumns {
+    std::vector<int32_t> productId, customerId, quantity, day;
+    std::vector<int64_t> amountCents;
+
+    size_t size() const { return day.size(); }
+
+    void reserve(size_t n) {
+        productId.reserve(n); customerId.reserve(n); quantity.reserve(n);
+        day.reserve(n); amountCents.reserve(n);
+    }
+};
+
+enum class GroupBy { Category, Region, Month };
+
+struct GroupRow {
+    std::string key;
+    int64_t amountCents = 0;
+    int64_t quantity = 0;
+    int64_t count = 0;
+};
+
+class StarSchema {
+public:
+    void addProduct(int id, std::string_view category) { productCategory_.set(id, categories_.intern(category)); }
+    void addCustomer(int id, std::string_view region) { customerRegion_.set(id, regions_.intern(region)); }
+
+    void addSale(int productId, int customerId, int quantity, int32_t day, double amount) {
+        sales_.productId.push_back(productId);
+        sales_.customerId.push_back(customerId);
+        sales_.quantity.push_back(quantity);
+        sales_.day.push_back(day);
+        sales_.amountCents.push_back(std::llround(amount * 100));
+        minDay_ = std::min(minDay_, day);
+        maxDay_ = std::max(maxDay_, day);
+    }
+
+    const SalesColumns& sales() const { return sales_; }
+    void reserve(size_t n) { sales_.reserve(n); }
+
+    // SUM(amount), SUM(quantity), COUNT(*) по группам. Итог упорядочен:
+    // категории и регионы - по убыванию суммы, месяцы - по времени.
+    std::vector<GroupRow> aggregate(GroupBy by, unsigned threads = 0) const {
+        size_t groups = groupCount(by) + 1; // последняя группа - неизвестный ключ
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t n = sales_.size();
+        threads = static_cast<unsigned>(std::min<size_t>(threads, n / kBlock + 1));
+
+        // день -> номер месяца считается один раз на каждый день диапазона
+        std::vector<uint32_t> dayMonth;
+        if (by == GroupBy::Month && n) {
+            uint32_t month0 = monthIndex(minDay_);
+            dayMonth.resize(static_cast<size_t>(maxDay_ - minDay_) + 1);
+            for (size_t d = 0; d < dayMonth.size(); ++d)
+                dayMonth[d] = monthIndex(minDay_ + static_cast<int32_t>(d)) - month0;
+        }
+
+        std::vector<Accumulator> partial(threads, Accumulator(groups));
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; ++t) {
+            size_t from = n * t / threads, to = n * (t + 1) / threads;
+            pool.emplace_back([&, t, from, to] { scan(by, dayMonth.data(), from, to, partial[t]); });
+        }
+        for (auto& th : pool) th.join();
+
+        Accumulator total(groups);
+        for (const Accumulator& a : partial)
+            for (size_t g = 0; g < groups; ++g) {
+                total.amount[g] += a.amount[g];
+                total.quantity[g] += a.quantity[g];
+                total.count[g] += a.count[g];
+            }
+
+        std::vector<GroupRow> out;
+        for (size_t g = 0; g < groups; ++g) {
+            if (!total.count[g]) continue;
+            out.push_back({groupName(by, g, groups - 1), total.amount[g], total.quantity[g], total.count[g]});
+        }
+        if (by != GroupBy::Month)
+            std::sort(out.begin(), out.end(), [](const GroupRow& a, const GroupRow& b) { return a.amountCents > b.amountCents; });
+        return out;
+    }
+
+private:
+    static constexpr size_t kBlock = 4096;
+    static constexpr size_t kMaskedGroups = 16;
+
+    struct Accumulator {
+        explicit Accumulator(size_t groups) : amount(groups), quantity(groups), count(groups) {}
+        std::vector<int64_t> amount, quantity, count;
+    };
+
+    size_t groupCount(GroupBy by) const {
+        switch (by) {
+            case GroupBy::Category: return categories_.size();
+            case GroupBy::Region: return regions_.size();
+            case GroupBy::Month: return sales_.size() ? monthIndex(maxDay_) - monthIndex(minDay_) + 1 : 0;
+        }
+        return 0;
+    }
+
+    static uint32_t monthIndex(int32_t day) {
+        int y;
+        unsigned m, d;
+        civilFromDays(day, y, m, d);
+        return static_cast<uint32_t>(y * 12 + static_cast<int>(m) - 1);
+    }
+
+    std::string groupName(GroupBy by, size_t g, size_t unknown) const {
+        if (g == unknown) return "(unknown)";
+        switch (by) {
+            case GroupBy::Category: return categories_.name(static_cast<uint32_t>(g));
+            case GroupBy::Region: return regions_.name(static_cast<uint32_t>(g));
+            case GroupBy::Month: {
+                uint32_t mi = monthIndex(minDay_) + static_cast<uint32_t>(g);
+                char buf[16];
+                std::snprintf(buf, sizeof(buf), "%04u-%02u", mi / 12, mi % 12 + 1);
+                return buf;
+            }
+        }
+        return {};
+    }
+
+    void scan(GroupBy by, const uint32_t* dayMonth, size_t from, size_t to, Accumulator& acc) const {
+        const size_t groups = acc.amount.size();
+        const uint32_t unknown = static_cast<uint32_t>(groups - 1);
+        uint32_t g[kBlock];
+
+        for (size_t base = from; base < to; base += kBlock) {
+            size_t len = std::min(kBlock, to - base);
+            // 1. код группы для каждой строки блока
+            for (size_t i = 0; i < len; ++i) {
+                uint32_t code;
+                switch (by) {
+                    case GroupBy::Category: code = productCategory_.get(sales_.productId[base + i]); break;
+                    case GroupBy::Region: code = customerRegion_.get(sales_.customerId[base + i]); break;
+                    default: code = dayMonth[sales_.day[base + i] - minDay_];
+                }
+                g[i] = code < unknown ? code : unknown;
+            }
+            const int64_t* amount = sales_.amountCents.data() + base;
+            const int32_t* qty = sales_.quantity.data() + base;
+            // 2. суммирование
+            if (groups <= kMaskedGroups) {
+                // по проходу на группу; циклы без ветвлений векторизуются компилятором
+                for (uint32_t k = 0; k < groups; ++k) {
+                    int64_t sa = 0, sq = 0, sc = 0;
+                    for (size_t i = 0; i < len; ++i) {
+                        int64_t hit = g[i] == k;
+                        sa += amount[i] * hit;
+                        sq += qty[i] * hit;
+                        sc += hit;
+                    }
+                    acc.amount[k] += sa;
+                    acc.quantity[k] += sq;
+                    acc.count[k] += sc;
+                }
+            } else {
+                for (size_t i = 0; i < len; ++i) {
+                    acc.amount[g[i]] += amount[i];
+                    acc.quantity[g[i]] += qty[i];
+                    ++acc.count[g[i]];
+                }
+            }
+        }
+    }
+
+    SalesColumns sales_;
+    StringDict categories_, regions_;
+    DenseLookup productCategory_, customerRegion_;
+    int32_t minDay_ = INT32_MAX, maxDay_ = INT32_MIN;
+};
+
+inline void printGroups(const char* title, const std::vector<GroupRow>& rows) {
+    std::cout << title << std::endl;
+    for (const GroupRow& r : rows) {
+        long long cents = std::llabs(r.amountCents);
+        std::cout << r.key << ": " << (r.amountCents < 0 ? "-" : "") << cents / 100 << "." << std::setw(2)
+                  << std::setfill('0') << cents % 100 << std::setfill(' ') << " (n=" << r.count
+                  << ", qty=" << r.quantity << ")" << std::endl;
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+// Инкрементальный ETL: состояние прошлого запуска хранится в файле.
+//   - отпечатки входных файлов (размер, mtime, хеш содержимого): неизменный
+//     файл измерения пропускается целиком;
+//   - хеши строк измерений по id: отправляются только новые и изменённые
+//     строки (изменённые - настоящим upsert);
+//   - водяной знак фактов (max sale_id / sale_date): отправляются только новые факты;
+//     если файл только дописан в конец, читается лишь дописанный хвост.
+// Состояние записывается атомарно (временный файл + rename) после успешной загрузки.
+
+#include "csv_reader.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+// Быстрый некриптографический хеш (по 8 байт за шаг) - для обнаружения изменений
+inline uint64_t hashBytes(const void* data, size_t n, uint64_t seed = 0) {
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed ^ (n * k);
+    auto mix = [&](uint64_t w) {
+        h ^= w * 0xBF58476D1CE4E5B9ull;
+        h = (h << 27 | h >> 37) * k;
+    };
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        mix(w);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, n - i);
+    mix(tail);
+    h ^= h >> 31;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 29);
+}
+
+inline uint64_t hashCombine(uint64_t h, std::string_view s) { return hashBytes(s.data(), s.size(), h); }
+inline uint64_t hashCombine(uint64_t h, int64_t v) { return hashBytes(&v, sizeof(v), h); }
+
+struct FileFingerprint {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    uint64_t hash = 0;
+};
+
+enum class FileStatus {
+    Unchanged,
+    Appended,  // старое содержимое - префикс нового, новые строки начинаются с appendedAt
+    Changed,
+    Missing
+};
+
+// Хеши строк измерения: id -> хеш полей
+class RowHashes {
+public:
+    enum class Change { New, Changed, Same };
+
+    Change update(int id, uint64_t hash) {
+        auto it = rows_.find(id);
+        if (it == rows_.end()) { rows_.emplace(id, hash); return Change::New; }
+        if (it->second == hash) return Change::Same;
+        it->second = hash;
+        return Change::Changed;
+    }
+
+    size_t size() const { return rows_.size(); }
+    const std::unordered_map<int, uint64_t>& rows() const { return rows_; }
+    std::unordered_map<int, uint64_t>& rows() { return rows_; }
+
+private:
+    std::unordered_map<int, uint64_t> rows_;
+};
+
+class EtlState {
+public:
+    int64_t maxSaleId = INT64_MIN;
+    int32_t maxSaleDay = INT32_MIN;
+
+    // Сравнивает файл с прошлым запуском. Хеш содержимого считается, только
+    // если изменились размер или mtime. now - текущий отпечаток.
+    FileStatus check(const std::string& path, FileFingerprint& now, size_t* appendedAt = nullptr) const {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return FileStatus::Missing;
+        now.size = static_cast<uint64_t>(st.st_size);
+#if defined(__APPLE__)
+        now.mtimeNs = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        now.mtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        auto it = files_.find(path);
+        if (it != files_.end() && it->second.size == now.size && it->second.mtimeNs == now.mtimeNs) {
+            now.hash = it->second.hash;
+            return FileStatus::Unchanged;
+        }
+        MappedFile f(path);
+        if (!f.isOpen()) return FileStatus::Missing;
+        now.hash = hashBytes(f.data(), f.size());
+        if (it == files_.end()) return FileStatus::Changed;
+        const FileFingerprint& prev = it->second;
+        if (prev.hash == now.hash) return FileStatus::Unchanged;
+        // Дописан в конец: прошлое содержимое целиком совпадает и кончалось переводом строки
+        if (prev.size > 0 && prev.size < now.size && f.data()[prev.size - 1] == '\n' &&
+            hashBytes(f.data(), prev.size) == prev.hash) {
+            if (appendedAt) *appendedAt = prev.size;
+            return FileStatus::Appended;
+        }
+        return FileStatus::Changed;
+    }
+
+    void remember(const std::string& path, const FileFingerprint& fp) { files_[path] = fp; }
+
+    RowHashes& rows(const std::string& table) { return rows_[table]; }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        char magic[8];
+        uint32_t version = 0;
+        in.read(magic, sizeof(magic));
+        read(in, version);
+        if (!in || std::memcmp(magic, kMagic, sizeof(magic)) != 0 || version != kVersion) return false;
+        read(in, maxSaleId);
+        read(in, maxSaleDay);
+        uint32_t nfiles = 0, ntables = 0;
+        read(in, nfiles);
+        for (uint32_t i = 0; i < nfiles && in; ++i) {
+            std::string name = readString(in);
+            FileFingerprint fp;
+            read(in, fp.size);
+            read(in, fp.mtimeNs);
+            read(in, fp.hash);
+            files_[name] = fp;
+        }
+        read(in, ntables);
+        for (uint32_t i = 0; i < ntables && in; ++i) {
+            std::string name = readString(in);
+            uint64_t n = 0;
+            read(in, n);
+            auto& rows = rows_[name].rows();
+            rows.reserve(n);
+            for (uint64_t j = 0; j < n && in; ++j) {
+                int32_t id;
+                uint64_t h;
+                read(in, id);
+                read(in, h);
+                rows.emplace(id, h);
+            }
+        }
+        return static_cast<bool>(in);
+    }
+
+    bool save(const std::string& path) const {
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(kMagic, sizeof(kMagic));
+            write(out, kVersion);
+            write(out, maxSaleId);
+            write(out, maxSaleDay);
+            write(out, static_cast<uint32_t>(files_.size()));
+            for (const auto& kv : files_) {
+                writeString(out, kv.first);
+                write(out, kv.second.size);
+                write(out, kv.second.mtimeNs);
+                write(out, kv.second.hash);
+            }
+            write(out, static_cast<uint32_t>(rows_.size()));
+            for (const auto& kv : rows_) {
+                writeString(out, kv.first);
+                write(out, static_cast<uint64_t>(kv.second.size()));
+                for (const auto& row : kv.second.rows()) {
+                    write(out, static_cast<int32_t>(row.first));
+                    write(out, row.second);
+                }
+            }
+            if (!out.flush()) return false;
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+private:
+    static constexpr char kMagic[8] = {'E', 'T', 'L', 'S', 'T', 'A', 'T', 'E'};
+    static constexpr uint32_t kVersion = 1;
+
+    template <class T> static void read(std::istream& in, T& v) { in.read(reinterpret_cast<char*>(&v), sizeof(v)); }
+    template <class T> static void write(std::ostream& out, const T& v) { out.write(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    static std::string readString(std::istream& in) {
+        uint32_t n = 0;
+        read(in, n);
+        std::string s(n, '\0');
+        in.read(&s[0], n);
+        return s;
+    }
+
+    static void writeString(std::ostream& out, const std::string& s) {
+        write(out, static_cast<uint32_t>(s.size()));
+        out.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+
+    std::map<std::string, FileFingerprint> files_;
+    std::map<std::string, RowHashes> rows_;
+};
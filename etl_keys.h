@@ -0,0 +1,155 @@
+#pragma once
+
+// Проверка внешних ключей фактов до отправки на сервер.
+// KeySet - множество id измерения: плотный битсет для небольших
+// неотрицательных id, открытая адресация для остальных. Ключи берутся
+// с сервера одним запросом (бинарный результат), поэтому учитывается и
+// история, загруженная прошлыми запусками. Отвергнутые строки пишутся
+// в файл отказов с кодом причины - COPY не обрывается на плохом ключе.
+
+#include "pg_binary.h"
+
+#include <libpq-fe.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class KeySet {
+public:
+    void insert(int64_t id) {
+        if (id >= 0 && id < kDenseLimit) {
+            size_t w = static_cast<size_t>(id) / 64;
+            if (w >= bits_.size()) bits_.resize(w + 1, 0);
+            uint64_t bit = uint64_t(1) << (id % 64);
+            if (!(bits_[w] & bit)) { bits_[w] |= bit; ++size_; }
+            return;
+        }
+        if ((used_ + 1) * 2 > slots_.size()) grow();
+        if (place(slots_, id)) { ++used_; ++size_; }
+    }
+
+    bool contains(int64_t id) const {
+        if (id >= 0 && id < kDenseLimit) {
+            size_t w = static_cast<size_t>(id) / 64;
+            return w < bits_.size() && (bits_[w] >> (id % 64) & 1);
+        }
+        if (slots_.empty()) return false;
+        size_t mask = slots_.size() - 1;
+        for (size_t i = slot(id, mask);; i = (i + 1) & mask) {
+            if (slots_[i] == id) return true;
+            if (slots_[i] == kEmpty) return false;
+        }
+    }
+
+    size_t size() const { return size_; }
+    void clear() { bits_.clear(); slots_.clear(); used_ = size_ = 0; }
+
+private:
+    static constexpr int64_t kDenseLimit = int64_t(1) << 26; // битсет до 8 МБ
+    static constexpr int64_t kEmpty = INT64_MIN;
+
+    static size_t slot(int64_t id, size_t mask) {
+        return static_cast<size_t>((static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    // true - ключ добавлен (его не было)
+    static bool place(std::vector<int64_t>& slots, int64_t id) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = slot(id, mask);; i = (i + 1) & mask) {
+            if (slots[i] == id) return false;
+            if (slots[i] == kEmpty) { slots[i] = id; return true; }
+        }
+    }
+
+    void grow() {
+        std::vector<int64_t> next(slots_.empty() ? 64 : slots_.size() * 2, kEmpty);
+        for (int64_t id : slots_) if (id != kEmpty) place(next, id);
+        slots_.swap(next);
+    }
+
+    std::vector<uint64_t> bits_;
+    std::vector<int64_t> slots_;
+    size_t used_ = 0, size_ = 0;
+};
+
+// Все значения целочисленной колонки (int4) таблицы; false - ошибка запроса
+inline bool fetchKeys(PGconn* conn, const std::string& table, const std::string& column, KeySet& keys) {
+    std::string sql = "SELECT " + column + " FROM " + table;
+    PGresult* res = PQexecParams(conn, sql.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
+    bool ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQftype(res, 0) == kInt4Oid;
+    if (!ok) {
+        std::cerr << "SQL Error: " << PQerrorMessage(conn) << std::endl;
+    } else {
+        for (int i = 0, n = PQntuples(res); i < n; ++i) {
+            if (PQgetisnull(res, i, 0)) continue;
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(PQgetvalue(res, i, 0));
+            uint32_t v = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+            keys.insert(static_cast<int32_t>(v));
+        }
+    }
+    PQclear(res);
+    return ok;
+}
+
+enum class RejectReason { ParseError, BadDate, UnknownProduct, UnknownCustomer };
+
+inline const char* rejectCode(RejectReason r) {
+    switch (r) {
+        case RejectReason::ParseError: return "PARSE_ERROR";
+        case RejectReason::BadDate: return "BAD_DATE";
+        case RejectReason::UnknownProduct: return "UNKNOWN_PRODUCT";
+        case RejectReason::UnknownCustomer: return "UNKNOWN_CUSTOMER";
+    }
+    return "UNKNOWN";
+}
+
+// Файл отказов: "код,исходная строка". Пустой путь - только счётчики.
+// Потокобезопасен: пишут и поток чтения, и поток преобразования.
+class RejectLog {
+public:
+    explicit RejectLog(const std::string& path) : path_(path) {
+        if (!path.empty()) {
+            out_.open(path, std::ios::trunc);
+            if (!out_) std::cerr << "Cannot open reject file: " << path << std::endl;
+            else out_ << "reason,row\n";
+        }
+    }
+
+    void reject(RejectReason reason, std::string_view row) {
+        while (!row.empty() && (row.back() == '\n' || row.back() == '\r')) row.remove_suffix(1);
+        std::lock_guard<std::mutex> lock(mu_);
+        ++counts_[static_cast<size_t>(reason)];
+        if (out_) {
+            out_ << rejectCode(reason) << ',';
+            out_.write(row.data(), static_cast<std::streamsize>(row.size()));
+            out_ << '\n';
+        }
+    }
+
+    void printSummary() {
+        std::lock_guard<std::mutex> lock(mu_);
+        size_t n = 0;
+        for (size_t c : counts_) n += c;
+        if (!n) return;
+        out_.flush();
+        std::cout << "🚫 Rejected " << n << " rows";
+        if (!path_.empty()) std::cout << " -> " << path_;
+        std::cout << ":";
+        for (size_t r = 0; r < kReasons; ++r)
+            if (counts_[r]) std::cout << " " << rejectCode(static_cast<RejectReason>(r)) << "=" << counts_[r];
+        std::cout << std::endl;
+    }
+
+private:
+    static constexpr size_t kReasons = 4;
+    std::string path_;
+    std::ofstream out_;
+    std::mutex mu_;
+    size_t counts_[kReasons] = {};
+};
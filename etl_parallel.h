@@ -0,0 +1,120 @@
+#pragma once
+
+// Параллельная загрузка фактов: строки заранее разбиты на партиции, каждая
+// партиция грузится своим потоком через своё соединение из пула (свой COPY,
+// свои транзакции). Отвергнутый батч повторяется с переподключением.
+
+#include "pg_copy.h"
+#include "pg_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ParallelLoadStats {
+    size_t connections = 0;
+    size_t rows = 0;
+    size_t inserted = 0;
+    size_t failed = 0;            // строк, не загруженных после всех повторов
+    size_t retries = 0;           // повторно отправленных батчей
+    size_t failedPartitions = 0;
+    double seconds = 0;
+
+    double rowsPerSec() const { return seconds > 0 ? rows / seconds : 0; }
+};
+
+// put(BulkLoader&, const Row&) пишет одну строку в загрузчик.
+// setup(BulkLoader&) - настройка загрузчика каждого потока (например, BatchHook)
+template <class Row, class Put>
+ParallelLoadStats loadPartitions(PgPool& pool, size_t connections,
+                                 const std::vector<std::vector<Row>>& partitions,
+                                 const std::string& table, const std::string& columns,
+                                 CopyOptions copy, int maxRetries, Put put,
+                                 const std::function<void(BulkLoader&)>& setup = nullptr) {
+    using Clock = std::chrono::steady_clock;
+    ParallelLoadStats total;
+    total.connections = std::min(connections, pool.size());
+    if (total.connections == 0) {
+        // Ни одного соединения: ничего не загружено, иначе вызывающий сочтёт загрузку успешной
+        for (const std::vector<Row>& rows : partitions) {
+            total.rows += rows.size();
+            total.failed += rows.size();
+            total.failedPartitions += !rows.empty();
+        }
+        std::cerr << "No connections to load " << table << ": " << total.failed << " rows not loaded" << std::endl;
+        return total;
+    }
+
+    size_t chunk = std::max<size_t>(copy.batchSize, 1);
+    copy.batchSize = std::numeric_limits<size_t>::max(); // батчи закрываем сами
+    std::atomic<size_t> nextPartition{0};
+    std::mutex mu;
+    auto started = Clock::now();
+
+    auto worker = [&] {
+        PooledConn conn(pool);
+        BulkLoader loader(conn.get(), table, columns, copy);
+        if (setup) setup(loader);
+        ParallelLoadStats local;
+        for (size_t p; (p = nextPartition.fetch_add(1)) < partitions.size();) {
+            const std::vector<Row>& rows = partitions[p];
+            bool partitionOk = true;
+            for (size_t from = 0; from < rows.size(); from += chunk) {
+                size_t to = std::min(rows.size(), from + chunk);
+                bool ok = false;
+                for (int attempt = 0; attempt <= maxRetries && !ok; ++attempt) {
+                    if (attempt > 0) {
+                        ++local.retries;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100 << std::min(attempt, 5)));
+                        if (!PgPool::ensureAlive(conn.get())) {
+                            std::cerr << "Reconnect for " << table << " failed (attempt " << attempt << " of "
+                                      << maxRetries << "): " << PQerrorMessage(conn.get());
+                            continue;
+                        }
+                        loader.reconnected();
+                    }
+                    size_t before = loader.stats().inserted;
+                    for (size_t i = from; i < to; ++i) put(loader, rows[i]);
+                    ok = loader.commit();
+                    if (ok) local.inserted += loader.stats().inserted - before;
+                }
+                local.rows += to - from;
+                if (!ok) {
+                    local.failed += to - from;
+                    partitionOk = false;
+                }
+            }
+            if (!partitionOk) {
+                ++local.failedPartitions;
+                std::cerr << "Partition " << p << " of " << table << " failed after "
+                          << maxRetries << " retries" << std::endl;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        total.rows += local.rows;
+        total.inserted += local.inserted;
+        total.failed += local.failed;
+        total.retries += local.retries;
+        total.failedPartitions += local.failedPartitions;
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < total.connections; ++i) threads.emplace_back(worker);
+    for (auto& t : threads) t.join();
+    total.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    return total;
+}
+
+inline void printParallelStats(const std::string& table, const ParallelLoadStats& s) {
+    std::cout << "📥 " << table << " x" << s.connections << " connections: " << s.rows << " rows ("
+              << s.inserted << " new, " << s.failed << " failed, " << s.retries << " retried batches, "
+              << s.failedPartitions << " failed partitions) in " << s.seconds << " s, "
+              << static_cast<size_t>(s.rowsPerSec()) << " rows/s" << std::endl;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+// Конвейерный ETL: чтение -> преобразование -> загрузка в трёх потоках.
+// Стадии обмениваются батчами строк через ограниченные lock-free очереди
+// (один производитель, один потребитель), поэтому память не зависит от
+// размера входного файла, а разбор, преобразование и сеть идут параллельно.
+
+#include "csv_source.h"
+#include "spsc_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct StageCounters {
+    std::atomic<size_t> rows{0};
+    std::atomic<size_t> dropped{0};
+    std::atomic<size_t> batches{0};
+    std::atomic<int64_t> busyNs{0}; // время полезной работы (без ожидания очередей)
+};
+
+struct QueueCounters {
+    size_t capacity = 0;
+    std::atomic<size_t> maxDepth{0};
+    std::atomic<size_t> depthSum{0};
+    std::atomic<size_t> samples{0};
+
+    void sample(size_t depth) {
+        depthSum.fetch_add(depth, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        size_t m = maxDepth.load(std::memory_order_relaxed);
+        while (depth > m && !maxDepth.compare_exchange_weak(m, depth, std::memory_order_relaxed)) {}
+    }
+
+    double avgDepth() const { return samples ? double(depthSum) / samples : 0; }
+};
+
+struct PipelineStats {
+    StageCounters reader, transform, loader;
+    QueueCounters parsed, transformed; // очереди reader->transform и transform->loader
+    double seconds = 0;
+};
+
+struct PipelineOptions {
+    size_t batchRows = 4096;   // строк в одном батче
+    size_t queueBatches = 8;   // батчей в каждой очереди
+    size_t startOffset = 0;    // >0 - читать с этого байта (начало строки, заголовка там нет)
+    std::function<void(std::string_view)> onBadRow; // исходный текст строки, которую не разобрал parse
+};
+
+// Запускает конвейер для одного CSV-файла (первая строка - заголовок,
+// если чтение не начинается с opt.startOffset). false - файл не открылся
+// или сжатый файл оборван/испорчен: прочитанное до ошибки уже загружено.
+//   parse(const CsvRow&, Raw&) -> bool       - поток чтения
+//   transform(const Raw&, Row&) -> bool      - поток преобразования/проверки
+//   load(const Row&)                         - вызывающий поток (загрузка)
+template <class Raw, class Row, class Parse, class Transform, class Load>
+bool runPipeline(const std::string& file, Parse parse, Transform transform, Load load,
+                 PipelineStats& stats, PipelineOptions opt = {}) {
+    using Clock = std::chrono::steady_clock;
+    auto ns = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+    };
+
+    CsvSource source;
+    if (!source.open(file, opt.startOffset)) {
+        std::cerr << "Cannot open file: " << file << std::endl;
+        return false;
+    }
+
+    SpscQueue<std::vector<Raw>> parsed(opt.queueBatches);
+    SpscQueue<std::vector<Row>> transformed(opt.queueBatches);
+    stats.parsed.capacity = parsed.capacity();
+    stats.transformed.capacity = transformed.capacity();
+    auto started = Clock::now();
+
+    std::thread reader([&] {
+        CsvRow row;
+        if (opt.startOffset == 0) source.next(row); // header
+        std::vector<Raw> batch;
+        batch.reserve(opt.batchRows);
+        Raw item;
+        auto t0 = Clock::now();
+        while (source.next(row)) {
+            if (row.size() == 1 && row[0].empty()) continue;
+            if (!parse(row, item)) {
+                stats.reader.dropped.fetch_add(1, std::memory_order_relaxed);
+                if (opt.onBadRow) opt.onBadRow(source.record());
+                continue;
+            }
+            batch.push_back(std::move(item));
+            if (batch.size() < opt.batchRows) continue;
+
+            stats.reader.rows.fetch_add(batch.size(), std::memory_order_relaxed);
+            stats.reader.batches.fetch_add(1, std::memory_order_relaxed);
+            stats.reader.busyNs.fetch_add(ns(t0, Clock::now()), std::memory_order_relaxed);
+            parsed.push(batch);
+            stats.parsed.sample(parsed.depth());
+            batch.clear();
+            batch.reserve(opt.batchRows);
+            t0 = Clock::now();
+        }
+        if (!batch.empty()) {
+            stats.reader.rows.fetch_add(batch.size(), std::memory_order_relaxed);
+            stats.reader.batches.fetch_add(1, std::memory_order_relaxed);
+            parsed.push(batch);
+        }
+        stats.reader.busyNs.fetch_add(ns(t0, Clock::now()), std::memory_order_relaxed);
+        parsed.close();
+    });
+
+    std::thread transformer([&] {
+        std::vector<Raw> in;
+        while (parsed.pop(in)) {
+            auto t0 = Clock::now();
+            std::vector<Row> out;
+            out.reserve(in.size());
+            Row r;
+            for (const Raw& raw : in) {
+                if (transform(raw, r)) out.push_back(std::move(r));
+                else stats.transform.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            stats.transform.rows.fetch_add(out.size(), std::memory_order_relaxed);
+            stats.transform.batches.fetch_add(1, std::memory_order_relaxed);
+            stats.transform.busyNs.fetch_add(ns(t0, Clock::now()), std::memory_order_relaxed);
+            transformed.push(out);
+            stats.transformed.sample(transformed.depth());
+        }
+        transformed.close();
+    });
+
+    std::vector<Row> batch;
+    while (transformed.pop(batch)) {
+        auto t0 = Clock::now();
+        for (const Row& r : batch) load(r);
+        stats.loader.rows.fetch_add(batch.size(), std::memory_order_relaxed);
+        stats.loader.batches.fetch_add(1, std::memory_order_relaxed);
+        stats.loader.busyNs.fetch_add(ns(t0, Clock::now()), std::memory_order_relaxed);
+    }
+
+    reader.join();
+    transformer.join();
+    stats.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    return source.error().empty();
+}
+
+inline void printPipelineStats(const std::string& name, const PipelineStats& s) {
+    auto stage = [&](const char* label, const StageCounters& c) {
+        double busy = c.busyNs / 1e9;
+        std::cout << "   " << label << ": " << c.rows << " rows, " << c.dropped << " dropped, "
+                  << c.batches << " batches, busy " << busy << " s ("
+                  << static_cast<size_t>(busy > 0 ? c.rows / busy : 0) << " rows/s)" << std::endl;
+    };
+    auto queue = [&](const char* label, const QueueCounters& q) {
+        std::cout << "   queue " << label << ": depth avg " << q.avgDepth() << ", max " << q.maxDepth
+                  << " of " << q.capacity << std::endl;
+    };
+    std::cout << "🔀 " << name << " pipeline, " << s.seconds << " s wall:" << std::endl;
+    stage("read     ", s.reader);
+    stage("transform", s.transform);
+    stage("load     ", s.loader);
+    queue("read->transform", s.parsed);
+    queue("transform->load", s.transformed);
+}
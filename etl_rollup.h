@@ -0,0 +1,251 @@
+#pragma once
+
+// Свёртка продаж category × region × month (таблица sales_rollup), которая
+// ведётся во время загрузки фактов, а не пересчитывается по всей истории.
+// RollupBatch подключается к BulkLoader фактов: копит строки текущего батча,
+// перед COMMIT сворачивает их в ячейки и прибавляет к sales_rollup
+// (ON CONFLICT DO UPDATE SET total = total + EXCLUDED.total) в той же
+// транзакции. Откаченный батч не попадает и в свёртку; дубликаты, которые
+// загрузчик пропустил, тоже не считаются.
+// Категория и регион - из измерений на сервере на момент загрузки: если
+// категория товара потом изменится, старые продажи останутся в старой
+// категории до полного пересчёта (rebuildRollup).
+
+#include "date_util.h"
+#include "etl_columnar.h"
+#include "pg_binary.h"
+#include "pg_copy.h"
+
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+inline const char* kRollupTable =
+    "CREATE TABLE IF NOT EXISTS sales_rollup ("
+    "category VARCHAR(100) NOT NULL, region VARCHAR(100) NOT NULL, month DATE NOT NULL, "
+    "total_amount DECIMAL(18,2) NOT NULL DEFAULT 0, total_quantity BIGINT NOT NULL DEFAULT 0, "
+    "sales_count BIGINT NOT NULL DEFAULT 0, PRIMARY KEY (category, region, month))";
+
+inline const char* kRollupColumns = "category, region, month, total_amount, total_quantity, sales_count";
+
+inline bool runRollupSql(PGconn* conn, const std::string& sql) {
+    PGresult* res = PQexec(conn, sql.c_str());
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) std::cerr << "SQL Error: " << PQerrorMessage(conn) << std::endl;
+    PQclear(res);
+    return ok;
+}
+
+// Первое число месяца даты (дни с 1970-01-01)
+inline int32_t monthStart(int32_t day) {
+    int y;
+    unsigned m, d;
+    civilFromDays(day, y, m, d);
+    return day - static_cast<int32_t>(d) + 1;
+}
+
+// Категории товаров и регионы покупателей. Неизвестный id и NULL - пустая строка (код 0).
+class RollupDims {
+public:
+    RollupDims() {
+        categories_.intern("");
+        regions_.intern("");
+    }
+
+    // Создаёт sales_rollup, если её нет, и читает измерения
+    bool fetch(PGconn* conn) {
+        return runRollupSql(conn, kRollupTable) &&
+               fetchAttribute(conn, "SELECT product_id, COALESCE(category, '') FROM products_dim",
+                              categories_, productCategory_) &&
+               fetchAttribute(conn, "SELECT customer_id, COALESCE(region, '') FROM customers_dim",
+                              regions_, customerRegion_);
+    }
+
+    uint32_t category(int productId) const { return known(productCategory_.get(productId)); }
+    uint32_t region(int customerId) const { return known(customerRegion_.get(customerId)); }
+    const StringDict& categories() const { return categories_; }
+    const StringDict& regions() const { return regions_; }
+
+private:
+    static uint32_t known(uint32_t code) { return code == DenseLookup::kMissing ? 0 : code; }
+
+    // Бинарный результат: int4 id и текст атрибута
+    static bool fetchAttribute(PGconn* conn, const char* sql, StringDict& dict, DenseLookup& lookup) {
+        PGresult* res = PQexecParams(conn, sql, 0, nullptr, nullptr, nullptr, nullptr, 1);
+        bool ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQftype(res, 0) == kInt4Oid;
+        if (!ok) {
+            std::cerr << "SQL Error: " << PQerrorMessage(conn) << std::endl;
+        } else {
+            for (int i = 0, n = PQntuples(res); i < n; ++i) {
+                if (PQgetisnull(res, i, 0)) continue;
+                std::string_view value(PQgetvalue(res, i, 1), static_cast<size_t>(PQgetlength(res, i, 1)));
+                lookup.set(loadBE32(PQgetvalue(res, i, 0)), dict.intern(value));
+            }
+        }
+        PQclear(res);
+        return ok;
+    }
+
+    StringDict categories_, regions_;
+    DenseLookup productCategory_, customerRegion_;
+};
+
+struct RollupStats {
+    size_t batches = 0;  // зафиксированных батчей
+    size_t rows = 0;     // учтённых строк фактов
+    size_t cells = 0;    // ячеек, отправленных в sales_rollup (сумма по батчам)
+    double seconds = 0;  // время свёртки и upsert
+
+    RollupStats& operator+=(const RollupStats& o) {
+        batches += o.batches;
+        rows += o.rows;
+        cells += o.cells;
+        seconds += o.seconds;
+        return *this;
+    }
+};
+
+class RollupBatch : public BatchHook {
+public:
+    explicit RollupBatch(const RollupDims& dims) : dims_(dims) {}
+
+    // Строка факта текущего батча; вызывать до записи строки в загрузчик,
+    // т.к. endRow может сразу закрыть батч
+    void add(int32_t saleId, int productId, int customerId, int32_t day, int quantity, double amount) {
+        rows_.push_back({saleId, dims_.category(productId), dims_.region(customerId), monthStart(day), quantity,
+                         std::llround(amount * 100)});
+    }
+
+    bool beforeCommit(PGconn* conn, const std::vector<int32_t>* inserted) override {
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<Cell> cells = aggregate(inserted);
+        bool ok = cells.empty() || upsert(conn, cells);
+        pending_.cells = cells.size();
+        pending_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        return ok;
+    }
+
+    void afterBatch(bool committed) override {
+        if (committed) {
+            ++pending_.batches;
+            stats_ += pending_;
+        } else {
+            stageReady_ = false;  // временная таблица могла пропасть вместе с транзакцией
+        }
+        pending_ = RollupStats();
+        rows_.clear();
+    }
+
+    const RollupStats& stats() const { return stats_; }
+
+private:
+    struct Row {
+        int32_t saleId;
+        uint32_t category, region;
+        int32_t month;
+        int32_t quantity;
+        int64_t cents;
+    };
+
+    struct Cell {
+        uint32_t category, region;
+        int32_t month;
+        int64_t cents = 0, quantity = 0, count = 0;
+    };
+
+    // Ячейки батча; inserted != nullptr - только реально вставленные sale_id
+    std::vector<Cell> aggregate(const std::vector<int32_t>* inserted) {
+        if (inserted) {
+            std::vector<int32_t> ids(*inserted);
+            std::sort(ids.begin(), ids.end());
+            rows_.erase(std::remove_if(rows_.begin(), rows_.end(), [&](const Row& r) {
+                return !std::binary_search(ids.begin(), ids.end(), r.saleId);
+            }), rows_.end());
+        }
+        pending_.rows = rows_.size();
+        auto key = [](const Row& r) { return std::make_tuple(r.category, r.region, r.month); };
+        std::sort(rows_.begin(), rows_.end(), [&](const Row& a, const Row& b) { return key(a) < key(b); });
+        std::vector<Cell> cells;
+        for (const Row& r : rows_) {
+            if (cells.empty() || cells.back().category != r.category || cells.back().region != r.region ||
+                cells.back().month != r.month)
+                cells.push_back(Cell{r.category, r.region, r.month});
+            cells.back().cents += r.cents;
+            cells.back().quantity += r.quantity;
+            ++cells.back().count;
+        }
+        return cells;
+    }
+
+    // Ячейки - во временную таблицу одним COPY, оттуда - upsert с прибавлением.
+    // Порядок по ключу одинаков во всех соединениях: параллельные батчи
+    // ждут друг друга на общих ячейках, но не взаимоблокируются.
+    bool upsert(PGconn* conn, const std::vector<Cell>& cells) {
+        const std::string stage = "etl_stage_sales_rollup";
+        if (!stageReady_) {
+            stageReady_ = runRollupSql(conn, "CREATE TEMP TABLE IF NOT EXISTS " + stage +
+                                                 " (LIKE sales_rollup INCLUDING DEFAULTS) ON COMMIT DELETE ROWS");
+            if (!stageReady_) return false;
+        }
+        CopyStream copy(CopyFormat::Binary);
+        if (!copy.start(conn, "COPY " + stage + " (" + kRollupColumns + ") FROM STDIN (FORMAT binary)"))
+            return false;
+        bool ok = true;
+        for (const Cell& c : cells) {
+            copy.beginRow(6);
+            copy.putText(dims_.categories().name(c.category));
+            copy.putText(dims_.regions().name(c.region));
+            copy.putDate(c.month);
+            copy.putUnscaled(c.cents);
+            copy.putInt64(c.quantity);
+            copy.putInt64(c.count);
+            copy.endRow();
+            ok = ok && copy.flushIfNeeded();
+        }
+        if (!ok) {
+            copy.abort();
+            return false;
+        }
+        return copy.finish() &&
+               runRollupSql(conn, std::string("INSERT INTO sales_rollup (") + kRollupColumns + ") SELECT " +
+                                      kRollupColumns + " FROM " + stage +
+                                      " ORDER BY category, region, month ON CONFLICT (category, region, month) "
+                                      "DO UPDATE SET total_amount = sales_rollup.total_amount + EXCLUDED.total_amount, "
+                                      "total_quantity = sales_rollup.total_quantity + EXCLUDED.total_quantity, "
+                                      "sales_count = sales_rollup.sales_count + EXCLUDED.sales_count");
+    }
+
+    const RollupDims& dims_;
+    std::vector<Row> rows_;
+    RollupStats pending_, stats_;
+    bool stageReady_ = false;
+};
+
+// Полный пересчёт по sales_fact (после изменения измерений или для сверки)
+inline bool rebuildRollup(PGconn* conn) {
+    if (!runRollupSql(conn, kRollupTable) || !runRollupSql(conn, "BEGIN")) return false;
+    bool ok = runRollupSql(conn, "TRUNCATE sales_rollup") &&
+         runRollupSql(conn, std::string("INSERT INTO sales_rollup (") + kRollupColumns + ") "
+                            "SELECT COALESCE(p.category, ''), COALESCE(c.region, ''), "
+                            "date_trunc('month', s.sale_date)::date, SUM(s.amount), SUM(s.quantity), COUNT(*) "
+                            "FROM sales_fact s "
+                            "LEFT JOIN products_dim p ON s.product_id = p.product_id "
+                            "LEFT JOIN customers_dim c ON s.customer_id = c.customer_id "
+                            "GROUP BY 1, 2, 3");
+    if (ok) return runRollupSql(conn, "COMMIT");
+    runRollupSql(conn, "ROLLBACK");
+    return false;
+}
+
+inline void printRollupStats(const RollupStats& s) {
+    std::cout << "🧮 sales_rollup: " << s.rows << " rows -> " << s.cells << " cells in " << s.batches
+              << " batches, " << s.seconds << " s" << std::endl;
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+// Бинарный колоночный снимок входных данных ETL (products / customers / sales).
+// Файл: заголовок с версией и таблицей секций, затем секции - по одной на
+// колонку, выровненные по 64 байтам. Колонки фиксированной ширины (int32,
+// double), category и region закодированы словарём, имена - в куче строк
+// (смещения uint64 + байты). У каждой секции своя CRC32C, у заголовка - своя.
+// Чтение - mmap без копирования: колонки отдаются указателями прямо в файл.
+// Порядок байт - родной (little-endian на x86-64 и ARM64).
+
+#include "crc32c.h"
+#include "csv_reader.h"
+#include "etl_columnar.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class SnapshotSection : uint32_t {
+    ProductId = 1, ProductPrice, ProductCategory, ProductNameOffsets, ProductNameHeap,
+    CategoryOffsets, CategoryHeap,
+    CustomerId, CustomerRegion, CustomerNameOffsets, CustomerNameHeap,
+    RegionOffsets, RegionHeap,
+    SaleId, SaleDay, SaleProductId, SaleCustomerId, SaleQuantity, SaleAmount,
+};
+
+// День продажи, который не разобрался как дата
+constexpr int32_t kSnapshotBadDay = INT32_MIN;
+
+template <class T>
+struct ColumnView {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    const T& operator[](size_t i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+};
+
+// Строки: offsets[i]..offsets[i + 1] в куче
+struct StringColumn {
+    ColumnView<uint64_t> offsets;
+    const char* heap = nullptr;
+
+    size_t size() const { return offsets.size ? offsets.size - 1 : 0; }
+    std::string_view operator[](size_t i) const {
+        return std::string_view(heap + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+    }
+};
+
+struct SnapshotProducts {
+    ColumnView<int32_t> id;
+    ColumnView<double> price;
+    ColumnView<uint32_t> category; // код в categories
+    StringColumn name, categories;
+
+    size_t size() const { return id.size; }
+};
+
+struct SnapshotCustomers {
+    ColumnView<int32_t> id;
+    ColumnView<uint32_t> region;   // код в regions
+    StringColumn name, regions;
+
+    size_t size() const { return id.size; }
+};
+
+struct SnapshotSales {
+    ColumnView<int32_t> id, day, productId, customerId, quantity; // day - дни с 1970-01-01
+    ColumnView<double> amount;
+
+    size_t size() const { return id.size; }
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sections;
+    uint32_t headerCrc;  // CRC заголовка и таблицы секций (при подсчёте поле равно 0)
+    uint32_t reserved;
+};
+
+struct SnapshotEntry {
+    uint32_t id;
+    uint32_t crc;
+    uint64_t offset;
+    uint64_t size;
+};
+
+constexpr char kSnapshotMagic[8] = {'E', 'T', 'L', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t kSnapshotVersion = 1;
+
+// Накопление колонок и запись файла
+class SnapshotBuilder {
+public:
+    void addProduct(int32_t id, std::string_view name, std::string_view category, double price) {
+        productId_.push_back(id);
+        productPrice_.push_back(price);
+        productCategory_.push_back(categories_.intern(category));
+        appendString(productNameOffsets_, productNameHeap_, name);
+    }
+
+    void addCustomer(int32_t id, std::string_view name, std::string_view region) {
+        customerId_.push_back(id);
+        customerRegion_.push_back(regions_.intern(region));
+        appendString(customerNameOffsets_, customerNameHeap_, name);
+    }
+
+    void addSale(int32_t id, int32_t day, int32_t productId, int32_t customerId, int32_t quantity, double amount) {
+        saleId_.push_back(id);
+        saleDay_.push_back(day);
+        saleProduct_.push_back(productId);
+        saleCustomer_.push_back(customerId);
+        saleQuantity_.push_back(quantity);
+        saleAmount_.push_back(amount);
+    }
+
+    size_t products() const { return productId_.size(); }
+    size_t customers() const { return customerId_.size(); }
+    size_t sales() const { return saleId_.size(); }
+
+    bool write(const std::string& path) const {
+        std::vector<uint64_t> categoryOffsets, regionOffsets;
+        std::string categoryHeap, regionHeap;
+        for (size_t i = 0; i < categories_.size(); ++i)
+            appendString(categoryOffsets, categoryHeap, categories_.name(static_cast<uint32_t>(i)));
+        for (size_t i = 0; i < regions_.size(); ++i)
+            appendString(regionOffsets, regionHeap, regions_.name(static_cast<uint32_t>(i)));
+
+        struct Blob { SnapshotSection id; const void* data; size_t size; };
+        auto vec = [](SnapshotSection id, const auto& v) {
+            return Blob{id, v.data(), v.size() * sizeof(v[0])};
+        };
+        auto offsets = [](SnapshotSection id, const std::vector<uint64_t>& v) {
+            // пустая колонка строк - одно нулевое смещение
+            static const uint64_t zero = 0;
+            return v.empty() ? Blob{id, &zero, sizeof(zero)} : Blob{id, v.data(), v.size() * sizeof(uint64_t)};
+        };
+        const Blob blobs[] = {
+            vec(SnapshotSection::ProductId, productId_),
+            vec(SnapshotSection::ProductPrice, productPrice_),
+            vec(SnapshotSection::ProductCategory, productCategory_),
+            offsets(SnapshotSection::ProductNameOffsets, productNameOffsets_),
+            vec(SnapshotSection::ProductNameHeap, productNameHeap_),
+            offsets(SnapshotSection::CategoryOffsets, categoryOffsets),
+            vec(SnapshotSection::CategoryHeap, categoryHeap),
+            vec(SnapshotSection::CustomerId, customerId_),
+            vec(SnapshotSection::CustomerRegion, customerRegion_),
+            offsets(SnapshotSection::CustomerNameOffsets, customerNameOffsets_),
+            vec(SnapshotSection::CustomerNameHeap, customerNameHeap_),
+            offsets(SnapshotSection::RegionOffsets, regionOffsets),
+            vec(SnapshotSection::RegionHeap, regionHeap),
+            vec(SnapshotSection::SaleId, saleId_),
+            vec(SnapshotSection::SaleDay, saleDay_),
+            vec(SnapshotSection::SaleProductId, saleProduct_),
+            vec(SnapshotSection::SaleCustomerId, saleCustomer_),
+            vec(SnapshotSection::SaleQuantity, saleQuantity_),
+            vec(SnapshotSection::SaleAmount, saleAmount_),
+        };
+        const size_t count = sizeof(blobs) / sizeof(blobs[0]);
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+        header.version = kSnapshotVersion;
+        header.sections = static_cast<uint32_t>(count);
+        std::vector<SnapshotEntry> entries(count);
+        uint64_t offset = align(sizeof(SnapshotHeader) + count * sizeof(SnapshotEntry));
+        for (size_t i = 0; i < count; ++i) {
+            entries[i].id = static_cast<uint32_t>(blobs[i].id);
+            entries[i].crc = crc32c(blobs[i].data, blobs[i].size);
+            entries[i].offset = offset;
+            entries[i].size = blobs[i].size;
+            offset = align(offset + blobs[i].size);
+        }
+        uint32_t crc = crc32c(&header, sizeof(header));
+        header.headerCrc = crc32c(entries.data(), entries.size() * sizeof(SnapshotEntry), crc);
+
+        std::string tmp = path + ".tmp";
+        FILE* out = std::fopen(tmp.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Cannot write snapshot: " << tmp << std::endl;
+            return false;
+        }
+        static const char pad[kAlign] = {};
+        uint64_t pos = sizeof(header) + count * sizeof(SnapshotEntry);
+        bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+                  std::fwrite(entries.data(), sizeof(SnapshotEntry), count, out) == count;
+        for (size_t i = 0; ok && i < count; ++i) {
+            ok = std::fwrite(pad, 1, entries[i].offset - pos, out) == entries[i].offset - pos &&
+                 std::fwrite(blobs[i].data, 1, blobs[i].size, out) == blobs[i].size;
+            pos = entries[i].offset + blobs[i].size;
+        }
+        ok = std::fclose(out) == 0 && ok;
+        if (ok) ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok) std::cerr << "Cannot write snapshot: " << path << std::endl;
+        return ok;
+    }
+
+private:
+    static constexpr size_t kAlign = 64;
+
+    static uint64_t align(uint64_t v) { return (v + kAlign - 1) / kAlign * kAlign; }
+
+    static void appendString(std::vector<uint64_t>& offsets, std::string& heap, std::string_view s) {
+        if (offsets.empty()) offsets.push_back(0);
+        heap.append(s.data(), s.size());
+        offsets.push_back(heap.size());
+    }
+
+    std::vector<int32_t> productId_, customerId_;
+    std::vector<double> productPrice_;
+    std::vector<uint32_t> productCategory_, customerRegion_;
+    std::vector<uint64_t> productNameOffsets_, customerNameOffsets_;
+    std::string productNameHeap_, customerNameHeap_;
+    StringDict categories_, regions_;
+    std::vector<int32_t> saleId_, saleDay_, saleProduct_, saleCustomer_, saleQuantity_;
+    std::vector<double> saleAmount_;
+};
+
+// Чтение снимка через mmap. verify - проверить CRC всех секций
+// (читает весь файл); CRC заголовка и границы секций проверяются всегда.
+class SnapshotReader {
+public:
+    bool open(const std::string& path, bool verify = false) {
+        path_ = path;
+        if (!file_.open(path)) return fail("cannot open");
+        if (file_.size() < sizeof(SnapshotHeader)) return fail("truncated header");
+        SnapshotHeader header;
+        std::memcpy(&header, file_.data(), sizeof(header));
+        if (std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0) return fail("not a snapshot");
+        if (header.version != kSnapshotVersion) return fail("unsupported version " + std::to_string(header.version));
+        size_t tableSize = size_t(header.sections) * sizeof(SnapshotEntry);
+        if (file_.size() < sizeof(header) + tableSize) return fail("truncated section table");
+        entries_.resize(header.sections);
+        std::memcpy(entries_.data(), file_.data() + sizeof(header), tableSize);
+        uint32_t expected = header.headerCrc;
+        header.headerCrc = 0;
+        uint32_t crc = crc32c(entries_.data(), tableSize, crc32c(&header, sizeof(header)));
+        if (crc != expected) return fail("header checksum mismatch");
+
+        for (const SnapshotEntry& e : entries_) {
+            if (e.offset > file_.size() || e.size > file_.size() - e.offset)
+                return fail("section " + std::to_string(e.id) + " out of bounds");
+            if (verify && crc32c(file_.data() + e.offset, e.size) != e.crc)
+                return fail("section " + std::to_string(e.id) + " checksum mismatch");
+        }
+
+        bool ok = column(SnapshotSection::ProductId, products_.id) &&
+                  column(SnapshotSection::ProductPrice, products_.price) &&
+                  column(SnapshotSection::ProductCategory, products_.category) &&
+                  strings(SnapshotSection::ProductNameOffsets, SnapshotSection::ProductNameHeap, products_.name) &&
+                  strings(SnapshotSection::CategoryOffsets, SnapshotSection::CategoryHeap, products_.categories) &&
+                  column(SnapshotSection::CustomerId, customers_.id) &&
+                  column(SnapshotSection::CustomerRegion, customers_.region) &&
+                  strings(SnapshotSection::CustomerNameOffsets, SnapshotSection::CustomerNameHeap, customers_.name) &&
+                  strings(SnapshotSection::RegionOffsets, SnapshotSection::RegionHeap, customers_.regions) &&
+                  column(SnapshotSection::SaleId, sales_.id) &&
+                  column(SnapshotSection::SaleDay, sales_.day) &&
+                  column(SnapshotSection::SaleProductId, sales_.productId) &&
+                  column(SnapshotSection::SaleCustomerId, sales_.customerId) &&
+                  column(SnapshotSection::SaleQuantity, sales_.quantity) &&
+                  column(SnapshotSection::SaleAmount, sales_.amount);
+        if (!ok) return false;
+
+        size_t np = products_.id.size, nc = customers_.id.size, ns = sales_.id.size;
+        if (products_.price.size != np || products_.category.size != np || products_.name.size() != np ||
+            customers_.region.size != nc || customers_.name.size() != nc ||
+            sales_.day.size != ns || sales_.productId.size != ns || sales_.customerId.size != ns ||
+            sales_.quantity.size != ns || sales_.amount.size != ns)
+            return fail("column lengths differ");
+        for (uint32_t code : products_.category)
+            if (code >= products_.categories.size()) return fail("bad category code");
+        for (uint32_t code : customers_.region)
+            if (code >= customers_.regions.size()) return fail("bad region code");
+        return true;
+    }
+
+    const SnapshotProducts& products() const { return products_; }
+    const SnapshotCustomers& customers() const { return customers_; }
+    const SnapshotSales& sales() const { return sales_; }
+
+private:
+    bool fail(const std::string& why) {
+        std::cerr << "Snapshot " << path_ << ": " << why << std::endl;
+        return false;
+    }
+
+    const SnapshotEntry* find(SnapshotSection id) const {
+        for (const SnapshotEntry& e : entries_)
+            if (e.id == static_cast<uint32_t>(id)) return &e;
+        return nullptr;
+    }
+
+    template <class T>
+    bool column(SnapshotSection id, ColumnView<T>& out) {
+        const SnapshotEntry* e = find(id);
+        if (!e) return fail("missing section " + std::to_string(static_cast<uint32_t>(id)));
+        if (e->size % sizeof(T) || e->offset % alignof(T)) return fail("misaligned section " + std::to_string(e->id));
+        out.data = reinterpret_cast<const T*>(file_.data() + e->offset);
+        out.size = static_cast<size_t>(e->size / sizeof(T));
+        return true;
+    }
+
+    bool strings(SnapshotSection offsets, SnapshotSection heap, StringColumn& out) {
+        ColumnView<char> bytes;
+        if (!column(offsets, out.offsets) || !column(heap, bytes)) return false;
+        if (out.offsets.size == 0) return fail("empty string offsets");
+        uint64_t prev = 0;
+        for (uint64_t off : out.offsets) {
+            if (off < prev || off > bytes.size) return fail("bad string offsets");
+            prev = off;
+        }
+        out.heap = bytes.data;
+        return true;
+    }
+
+    std::string path_;
+    MappedFile file_;
+    std::vector<SnapshotEntry> entries_;
+    SnapshotProducts products_;
+    SnapshotCustomers customers_;
+    SnapshotSales sales_;
+};
@@ -1,76 +1,96 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
 #include <libpq-fe.h>
 #include <iomanip>
-#include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "csv_reader.h"
+#include "csv_source.h"
+#include "date_util.h"
+#include "etl_columnar.h"
+#include "etl_incremental.h"
+#include "etl_keys.h"
+#include "etl_parallel.h"
+#include "etl_pipeline.h"
+#include "etl_rollup.h"
+#include "etl_snapshot.h"
+#include "pg_copy.h"
+#include "pg_pipeline.h"
 
 struct Product { int id; std::string name, category; double price; };
 struct Customer { int id; std::string name, region; };
 struct Sale { int id, product_id, customer_id, quantity; double amount; std::string sale_date_str; };
+// Строка факта после преобразования: дата - число дней с 1970-01-01
+struct Fact { int id, day, product_id, customer_id, quantity; double amount; };
 
-std::string toDate(const std::string& date_str) {
-    std::tm tm = {};
-    std::istringstream ss(date_str);
-    ss >> std::get_time(&tm, "%Y-%m-%d");
-    if (ss.fail()) return "";
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d");
-    return oss.str();
-}
-
-std::vector<Product> loadProducts(const std::string& file) {
-    std::vector<Product> data;
-    std::ifstream f(file);
-    if (!f.is_open()) return data;
-    std::string line; std::getline(f, line); // header
-    while (std::getline(f, line)) {
-        std::stringstream ss(line);
-        Product p; std::string temp;
-        std::getline(ss, temp, ','); p.id = std::stoi(temp);
-        std::getline(ss, p.name, ',');
-        std::getline(ss, p.category, ',');
-        std::getline(ss, temp, ','); p.price = std::stod(temp);
-        data.push_back(p);
-    }
-    return data;
-}
-
-std::vector<Customer> loadCustomers(const std::string& file) {
-    std::vector<Customer> data;
-    std::ifstream f(file);
-    if (!f.is_open()) return data;
-    std::string line; std::getline(f, line);
-    while (std::getline(f, line)) {
-        std::stringstream ss(line);
-        Customer c; std::string temp;
-        std::getline(ss, temp, ','); c.id = std::stoi(temp);
-        std::getline(ss, c.name, ',');
-        std::getline(ss, c.region, ',');
-        data.push_back(c);
-    }
-    return data;
-}
-
-std::vector<Sale> loadSales(const std::string& file) {
-    std::vector<Sale> data;
-    std::ifstream f(file);
-    if (!f.is_open()) return data;
-    std::string line; std::getline(f, line);
-    while (std::getline(f, line)) {
-        std::stringstream ss(line);
-        Sale s; std::string temp;
-        std::getline(ss, temp, ','); s.id = std::stoi(temp);
-        std::getline(ss, s.sale_date_str, ',');
-        std::getline(ss, temp, ','); s.product_id = std::stoi(temp);
-        std::getline(ss, temp, ','); s.customer_id = std::stoi(temp);
-        std::getline(ss, temp, ','); s.quantity = std::stoi(temp);
-        std::getline(ss, temp, ','); s.amount = std::stod(temp);
-        data.push_back(s);
-    }
-    return data;
+bool parseProduct(const CsvRow& r, Product& p) {
+    if (r.size() < 4 || !parseInt(r[0], p.id) || !parseDouble(r[3], p.price)) return false;
+    p.name.assign(r[1]);
+    p.category.assign(r[2]);
+    return true;
+}
+
+bool parseCustomer(const CsvRow& r, Customer& c) {
+    if (r.size() < 3 || !parseInt(r[0], c.id)) return false;
+    c.name.assign(r[1]);
+    c.region.assign(r[2]);
+    return true;
+}
+
+bool parseSale(const CsvRow& r, Sale& s) {
+    if (r.size() < 6 || !parseInt(r[0], s.id) || !parseInt(r[2], s.product_id) ||
+        !parseInt(r[3], s.customer_id) || !parseInt(r[4], s.quantity) || !parseDouble(r[5], s.amount))
+        return false;
+    s.sale_date_str.assign(r[1]);
+    return true;
+}
+
+// Общий проход по CSV: пропускает заголовок, битые строки считает и пропускает
+// (onBad получает их исходный текст), каждую разобранную отдаёт в fn.
+// from > 0 - читать с этого байта (начало строки после заголовка).
+// false - файл не открылся или сжатый файл оборван/испорчен.
+template <class T, class Parse, class Fn>
+bool scanCsv(const std::string& file, Parse parse, Fn fn, size_t from = 0,
+             const std::function<void(std::string_view)>& onBad = nullptr) {
+    CsvSource source;
+    if (!source.open(file, from)) {
+        std::cerr << "Cannot open file: " << file << std::endl;
+        return false;
+    }
+    CsvRow row;
+    if (from == 0) source.next(row); // header
+    size_t bad = 0;
+    T item;
+    while (source.next(row)) {
+        if (row.size() == 1 && row[0].empty()) continue; // пустая строка
+        if (parse(row, item)) {
+            fn(item);
+        } else {
+            ++bad;
+            if (onBad) onBad(source.record());
+        }
+    }
+    if (bad) std::cerr << file << ": skipped " << bad << " malformed rows" << std::endl;
+    return source.error().empty();
+}
+
+template <class T, class Parse>
+bool loadCsv(const std::string& file, Parse parse, std::vector<T>& data, size_t from = 0,
+             const std::function<void(std::string_view)>& onBad = nullptr) {
+    return scanCsv<T>(file, parse, [&](const T& item) { data.push_back(item); }, from, onBad);
+}
+
+bool loadProducts(const std::string& file, std::vector<Product>& out) { return loadCsv(file, parseProduct, out); }
+bool loadCustomers(const std::string& file, std::vector<Customer>& out) { return loadCsv(file, parseCustomer, out); }
+bool loadSales(const std::string& file, std::vector<Sale>& out, size_t from = 0,
+               const std::function<void(std::string_view)>& onBad = nullptr) {
+    return loadCsv(file, parseSale, out, from, onBad);
 }
 
 bool exec(PGconn* conn, const std::string& sql) {
@@ -81,72 +101,908 @@ bool exec(PGconn* conn, const std::string& sql) {
     return ok;
 }
 
-int main() {
-    // Замените на свой пароль!
-    const char* conninfo = "host=localhost port=5432 dbname=my_db user=postgres password=mypassword123";
+enum class PartitionBy { Id, Date };
+enum class Analytics { Local, Server, Both };
 
-    PGconn* conn = PQconnectdb(conninfo);
-    if (PQstatus(conn) != CONNECTION_OK) {
-        std::cerr << "Connection failed: " << PQerrorMessage(conn) << std::endl;
-        PQfinish(conn);
-        return 1;
+struct EtlOptions {
+    CopyOptions copy;
+    bool pipelined = false;
+    PipelineOptions pipeline;
+    size_t connections = 1;   // >1 - параллельная загрузка фактов
+    PartitionBy partitionBy = PartitionBy::Id;
+    int retries = 3;
+    bool scaling = false;     // замер на 1/2/4/8/16 соединениях
+    bool asyncDims = false;   // измерения через конвейер libpq вместо COPY
+    size_t syncEvery = 1000;
+    size_t benchInsertRows = 0; // >0 - только микробенчмарк INSERT
+    Analytics analytics = Analytics::Server;
+    bool incremental = false; // только изменения с прошлого запуска
+    std::string statePath = "etl_state.bin";
+    bool checkKeys = true;    // проверять внешние ключи фактов до отправки
+    std::string rejectsPath = "rejects.csv";
+    std::string snapshotBuild;  // только записать снимок CSV в этот файл
+    std::string snapshot;       // грузить из снимка вместо CSV
+    bool verifySnapshot = false; // проверить CRC всех секций снимка
+    bool noLoad = false;        // без базы: только локальная аналитика по снимку
+    bool rollup = false;        // вести sales_rollup вместе с загрузкой фактов
+    bool rollupRebuild = false; // пересчитать sales_rollup по всей sales_fact после загрузки
+};
+
+// Transform: проверка даты и приведение к строке факта
+bool toFact(const Sale& s, Fact& f) {
+    if (!parseDate(s.sale_date_str, f.day)) return false;
+    f.id = s.id;
+    f.product_id = s.product_id;
+    f.customer_id = s.customer_id;
+    f.quantity = s.quantity;
+    f.amount = s.amount;
+    return true;
+}
+
+// Проверка факта до отправки: дата и внешние ключи (если ключи получены).
+// Отвергнутая строка уходит в файл отказов с кодом причины.
+struct FactCheck {
+    explicit FactCheck(const std::string& rejectsPath) : rejects(rejectsPath) {}
+    KeySet products, customers;
+    bool keys = false;
+    RejectLog rejects;
+};
+
+// Ключи измерений - с сервера, после загрузки измерений этого запуска
+void fetchDimensionKeys(PGconn* conn, const EtlOptions& opt, FactCheck& check) {
+    if (!opt.checkKeys) return;
+    auto t0 = std::chrono::steady_clock::now();
+    check.keys = fetchKeys(conn, "products_dim", "product_id", check.products) &&
+                 fetchKeys(conn, "customers_dim", "customer_id", check.customers);
+    if (!check.keys) {
+        std::cerr << "Foreign keys will be checked by the server only" << std::endl;
+        return;
     }
-    std::cout << "✅ Connected to my_db!" << std::endl;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "🔑 Keys: " << check.products.size() << " products, " << check.customers.size()
+              << " customers (" << ms << " ms)" << std::endl;
+}
+
+// Измерения для свёртки - с сервера, как и ключи; false - свёртка в этом запуске не ведётся
+bool fetchRollupDims(PGconn* conn, const EtlOptions& opt, RollupDims& dims) {
+    if (!opt.rollup) return false;
+    if (!dims.fetch(conn)) {
+        std::cerr << "sales_rollup will not be maintained in this run" << std::endl;
+        return false;
+    }
+    std::cout << "🧮 Rollup: " << dims.categories().size() << " categories x " << dims.regions().size()
+              << " regions" << std::endl;
+    return true;
+}
+
+std::string formatSale(const Sale& s) {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "%d,%s,%d,%d,%d,%.15g", s.id, s.sale_date_str.c_str(), s.product_id,
+                  s.customer_id, s.quantity, s.amount);
+    return buf;
+}
+
+// Внешние ключи факта; false - причина в reason
+bool validKeys(const Fact& f, const FactCheck& check, RejectReason& reason) {
+    if (check.keys && !check.products.contains(f.product_id)) reason = RejectReason::UnknownProduct;
+    else if (check.keys && !check.customers.contains(f.customer_id)) reason = RejectReason::UnknownCustomer;
+    else return true;
+    return false;
+}
+
+bool admitFact(const Sale& s, Fact& f, FactCheck& check) {
+    RejectReason reason = RejectReason::BadDate;
+    if (toFact(s, f) && validKeys(f, check, reason)) return true;
+    check.rejects.reject(reason, formatSale(s));
+    return false;
+}
+
+void putProduct(BulkLoader& loader, const Product& p) {
+    CopyStream& row = loader.beginRow();
+    row.putInt(p.id);
+    row.putText(p.name);
+    row.putText(p.category);
+    row.putNumeric(p.price);
+    loader.endRow();
+}
+
+void putCustomer(BulkLoader& loader, const Customer& c) {
+    CopyStream& row = loader.beginRow();
+    row.putInt(c.id);
+    row.putText(c.name);
+    row.putText(c.region);
+    loader.endRow();
+}
+
+void putFact(BulkLoader& loader, const Fact& f) {
+    CopyStream& row = loader.beginRow();
+    row.putInt(f.id);
+    row.putDate(f.day);
+    row.putInt(f.product_id);
+    row.putInt(f.customer_id);
+    row.putInt(f.quantity);
+    row.putNumeric(f.amount);
+    loader.endRow();
+}
+
+// Факт плюс его вклад в свёртку: к загрузчику подключена RollupBatch
+void putRolledFact(BulkLoader& loader, const Fact& f) {
+    static_cast<RollupBatch*>(loader.hook())->add(f.id, f.product_id, f.customer_id, f.day, f.quantity, f.amount);
+    putFact(loader, f);
+}
+
+// Upsert измерений через конвейер libpq: один RTT на группу, а не на строку.
+// Запросы подготавливаются один раз, параметры передаются в бинарном виде.
+const char* kProductUpsert =
+    "INSERT INTO products_dim (product_id, product_name, category, price) "
+    "VALUES ($1, $2, $3, $4) ON CONFLICT ";
+const char* kCustomerUpsert =
+    "INSERT INTO customers_dim (customer_id, customer_name, region) "
+    "VALUES ($1, $2, $3) ON CONFLICT ";
+// Инкрементальный режим: изменённая строка измерения перезаписывает старую
+const char* kProductUpdate =
+    "(product_id) DO UPDATE SET product_name = EXCLUDED.product_name, "
+    "category = EXCLUDED.category, price = EXCLUDED.price";
+const char* kCustomerUpdate =
+    "(customer_id) DO UPDATE SET customer_name = EXCLUDED.customer_name, region = EXCLUDED.region";
+
+bool prepareUpserts(PGconn* conn, bool update) {
+    std::string product = std::string(kProductUpsert) + (update ? kProductUpdate : "DO NOTHING");
+    std::string customer = std::string(kCustomerUpsert) + (update ? kCustomerUpdate : "DO NOTHING");
+    return prepareStatement(conn, "upsert_product", product.c_str(), {kInt4Oid, kTextOid, kTextOid, kNumericOid}) &&
+           prepareStatement(conn, "upsert_customer", customer.c_str(), {kInt4Oid, kTextOid, kTextOid});
+}
+
+void upsertProduct(AsyncExecutor& ex, PgParams& params, const Product& p) {
+    params.clear();
+    params.addInt4(p.id);
+    params.addText(p.name, kTextOid);
+    params.addText(p.category, kTextOid);
+    params.addNumeric(p.price);
+    ex.sendPrepared("upsert_product", params);
+}
+
+void upsertCustomer(AsyncExecutor& ex, PgParams& params, const Customer& c) {
+    params.clear();
+    params.addInt4(c.id);
+    params.addText(c.name, kTextOid);
+    params.addText(c.region, kTextOid);
+    ex.sendPrepared("upsert_customer", params);
+}
+
+const char* kProductColumns = "product_id, product_name, category, price";
+const char* kCustomerColumns = "customer_id, customer_name, region";
+const char* kFactColumns = "sale_id, sale_date, product_id, customer_id, quantity, amount";
+const char* kTimeColumns = "date, year, quarter, month, day, day_of_week";
+
+// time_dim: одна строка на каждую встреченную дату
+bool loadTimeDim(PGconn* conn, const DateSet& dates, const CopyOptions& copy) {
+    BulkLoader loader(conn, "time_dim", kTimeColumns, copy);
+    for (const DateParts& d : dates.parts()) {
+        CopyStream& row = loader.beginRow();
+        row.putDate(d.days);
+        row.putInt(d.year);
+        row.putInt(static_cast<int32_t>(d.quarter));
+        row.putInt(static_cast<int32_t>(d.month));
+        row.putInt(static_cast<int32_t>(d.day));
+        row.putText(weekdayName(d.dayOfWeek));
+        loader.endRow();
+    }
+    loader.finish();
+    printLoadStats(loader);
+    return loader.stats().failed == 0;
+}
+
+// Партиции фактов: диапазоны sale_id или хеш даты продажи
+std::vector<std::vector<Fact>> partitionFacts(const std::vector<Fact>& facts, size_t n, PartitionBy by) {
+    std::vector<std::vector<Fact>> parts(n);
+    if (facts.empty()) return parts;
+    long long lo = facts.front().id, hi = lo;
+    for (const Fact& f : facts) { lo = std::min<long long>(lo, f.id); hi = std::max<long long>(hi, f.id); }
+    for (auto& p : parts) p.reserve(facts.size() / n + 1);
+    for (const Fact& f : facts) {
+        size_t k = by == PartitionBy::Id
+            ? static_cast<size_t>((f.id - lo) * static_cast<long long>(n) / (hi - lo + 1))
+            : (static_cast<uint32_t>(f.day) * 2654435761u) % n;
+        parts[k].push_back(f);
+    }
+    return parts;
+}
+
+// COPY измерения: в инкрементальном режиме всегда через временную таблицу и upsert
+CopyOptions dimCopy(const EtlOptions& opt, const char* update) {
+    CopyOptions copy = opt.copy;
+    if (opt.incremental) {
+        copy.skipDuplicates = true;
+        copy.onConflict = update;
+    }
+    return copy;
+}
+
+// Измерения: COPY или конвейер libpq. each(put) перебирает строки и вызывает put для каждой.
+// false - часть строк не загружена
+template <class Each>
+bool loadProductDim(PGconn* conn, const EtlOptions& opt, Each each) {
+    if (opt.asyncDims) {
+        AsyncExecutor ex(conn, opt.syncEvery);
+        PgParams params;
+        if (ex.begin()) each([&](const Product& p) { upsertProduct(ex, params, p); });
+        bool ok = ex.finish();
+        printAsyncStats("products_dim", ex);
+        return ok && ex.stats().failed == 0;
+    }
+    BulkLoader loader(conn, "products_dim", kProductColumns, dimCopy(opt, kProductUpdate));
+    each([&](const Product& p) { putProduct(loader, p); });
+    loader.finish();
+    printLoadStats(loader);
+    return loader.stats().failed == 0;
+}
+
+template <class Each>
+bool loadCustomerDim(PGconn* conn, const EtlOptions& opt, Each each) {
+    if (opt.asyncDims) {
+        AsyncExecutor ex(conn, opt.syncEvery);
+        PgParams params;
+        if (ex.begin()) each([&](const Customer& c) { upsertCustomer(ex, params, c); });
+        bool ok = ex.finish();
+        printAsyncStats("customers_dim", ex);
+        return ok && ex.stats().failed == 0;
+    }
+    BulkLoader loader(conn, "customers_dim", kCustomerColumns, dimCopy(opt, kCustomerUpdate));
+    each([&](const Customer& c) { putCustomer(loader, c); });
+    loader.finish();
+    printLoadStats(loader);
+    return loader.stats().failed == 0;
+}
+
+// Микробенчмарк вставки: SQL-строка, подготовленный запрос с текстовыми
+// и с бинарными параметрами (все синхронно), плюс бинарный в конвейере
+void runInsertBenchmark(PGconn* conn, size_t n) {
+    if (!exec(conn, "CREATE TEMP TABLE IF NOT EXISTS bench_insert "
+                    "(id INT, name TEXT, sale_date DATE, quantity INT, amount DECIMAL(10,2))"))
+        return;
+    const char* sql = "INSERT INTO bench_insert VALUES ($1, $2, $3, $4, $5)";
+    if (!prepareStatement(conn, "bench_text", sql, {}) ||
+        !prepareStatement(conn, "bench_binary", sql, {kInt4Oid, kTextOid, kDateOid, kInt4Oid, kNumericOid}))
+        return;
+
+    const int32_t day0 = daysFromCivil(2024, 1, 1);
+    auto rowName = [](size_t i) { return "O'Neil #" + std::to_string(i); }; // кавычка ломала конкатенацию
+    auto report = [&](const char* label, std::chrono::steady_clock::time_point t0) {
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << std::left << std::setw(24) << label << std::right << std::setw(12)
+                  << static_cast<size_t>(n / sec) << " rows/s " << std::setw(10) << std::fixed
+                  << std::setprecision(2) << sec * 1e6 / n << " us/row" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    };
+    auto run = [&](const char* label, auto insertRow) {
+        exec(conn, "TRUNCATE bench_insert");
+        exec(conn, "BEGIN");
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) insertRow(i);
+        exec(conn, "COMMIT");
+        report(label, t0);
+    };
+
+    std::cout << "\n⏱  INSERT benchmark, " << n << " rows:\n";
+    run("text concatenation", [&](size_t i) {
+        char date[11] = {};
+        formatDate(day0 + static_cast<int32_t>(i % 365), date);
+        std::string raw = rowName(i);
+        char* name = PQescapeLiteral(conn, raw.c_str(), raw.size());
+        exec(conn, "INSERT INTO bench_insert VALUES (" + std::to_string(i) + ", " + name + ", '" + date +
+                   "', " + std::to_string(i % 10 + 1) + ", " + std::to_string((i % 10000) / 100.0) + ")");
+        PQfreemem(name);
+    });
+    PgParams params;
+    run("prepared, text params", [&](size_t i) {
+        char date[11] = {};
+        formatDate(day0 + static_cast<int32_t>(i % 365), date);
+        char amount[32];
+        std::snprintf(amount, sizeof(amount), "%.2f", (i % 10000) / 100.0);
+        params.clear();
+        params.addText(std::to_string(i));
+        params.addText(rowName(i));
+        params.addText(date);
+        params.addText(std::to_string(i % 10 + 1));
+        params.addText(amount);
+        execPrepared(conn, "bench_text", params);
+    });
+    auto binaryRow = [&](size_t i) {
+        params.clear();
+        params.addInt4(static_cast<int32_t>(i));
+        params.addText(rowName(i), kTextOid);
+        params.addDate(day0 + static_cast<int32_t>(i % 365));
+        params.addInt4(static_cast<int32_t>(i % 10 + 1));
+        params.addNumeric((i % 10000) / 100.0);
+    };
+    run("prepared, binary", [&](size_t i) {
+        binaryRow(i);
+        execPrepared(conn, "bench_binary", params);
+    });
+
+    // Конвейер: одна неявная транзакция на группу, отдельный BEGIN не нужен
+    exec(conn, "TRUNCATE bench_insert");
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        AsyncExecutor ex(conn, 10000);
+        if (ex.begin()) {
+            for (size_t i = 0; i < n; ++i) {
+                binaryRow(i);
+                ex.sendPrepared("bench_binary", params);
+            }
+        }
+        ex.finish();
+    }
+    report("prepared, binary, pipe", t0);
+}
+
+// Масштабирование: одна и та же загрузка в UNLOGGED-копию sales_fact на 1..16 соединениях
+void runScaling(PGconn* conn, PgPool& pool, const std::vector<Fact>& facts, const EtlOptions& opt) {
+    const std::string table = "sales_fact_scaling";
+    if (!exec(conn, "CREATE UNLOGGED TABLE IF NOT EXISTS " + table +
+                    " (LIKE sales_fact INCLUDING DEFAULTS INCLUDING CONSTRAINTS INCLUDING INDEXES)"))
+        return;
+    std::cout << "\n📐 SCALING (" << facts.size() << " rows):\n";
+    double base = 0;
+    for (size_t n : {1, 2, 4, 8, 16}) {
+        if (n > pool.size()) break;
+        exec(conn, "TRUNCATE " + table);
+        auto parts = partitionFacts(facts, n, opt.partitionBy);
+        ParallelLoadStats st = loadPartitions(pool, n, parts, table, kFactColumns, opt.copy,
+                                              opt.retries, putFact);
+        if (n == 1) base = st.seconds;
+        std::cout << std::setw(4) << n << " conn: " << std::fixed << std::setprecision(3) << st.seconds
+                  << " s, " << static_cast<size_t>(st.rowsPerSec()) << " rows/s, speedup x"
+                  << std::setprecision(2) << (st.seconds > 0 ? base / st.seconds : 0) << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+    exec(conn, "DROP TABLE " + table);
+}
+
+void addToStar(StarSchema* star, const Product& p) { if (star) star->addProduct(p.id, p.category); }
+void addToStar(StarSchema* star, const Customer& c) { if (star) star->addCustomer(c.id, c.region); }
+void addToStar(StarSchema* star, const Fact& f) {
+    if (star) star->addSale(f.product_id, f.customer_id, f.quantity, f.day, f.amount);
+}
+
+// Инкрементальный режим. Хеш строки измерения - по всем полям, кроме id.
+uint64_t rowHash(const Product& p) {
+    return hashCombine(hashCombine(hashCombine(0, p.name), p.category), toUnscaled(p.price, 2));
+}
+uint64_t rowHash(const Customer& c) { return hashCombine(hashCombine(0, c.name), c.region); }
+
+// true - строка новая или изменилась с прошлого запуска (без состояния - всегда)
+template <class T>
+bool changedRow(EtlState* state, const char* table, const T& row) {
+    return !state || state->rows(table).update(row.id, rowHash(row)) != RowHashes::Change::Same;
+}
+
+void advanceWatermark(EtlState* state, const Fact& f) {
+    if (!state) return;
+    state->maxSaleId = std::max<int64_t>(state->maxSaleId, f.id);
+    state->maxSaleDay = std::max(state->maxSaleDay, f.day);
+}
+
+// Входные файлы; каждый может быть сжат (sales.csv.gz, sales.csv.zst)
+struct InputFiles {
+    std::string products = findCsv("products.csv");
+    std::string customers = findCsv("customers.csv");
+    std::string sales = findCsv("sales.csv");
+};
+
+// Что читать из входного файла: весь, только дописанный хвост или ничего
+struct InputPlan {
+    bool skip = false;
+    size_t from = 0;
+    FileFingerprint fp;
+};
+
+InputPlan planInput(const EtlState* state, const std::string& file) {
+    InputPlan plan;
+    if (!state) return plan;
+    switch (state->check(file, plan.fp, &plan.from)) {
+        case FileStatus::Unchanged:
+            plan.skip = true;
+            std::cout << "⏭  " << file << " unchanged since last run, skipped" << std::endl;
+            break;
+        case FileStatus::Appended:
+            std::cout << "➕ " << file << " appended since last run, reading from byte " << plan.from << std::endl;
+            break;
+        default:
+            plan.from = 0;
+    }
+    return plan;
+}
+
+// Конвейерный режим: файлы не загружаются в память целиком.
+// star != nullptr - дополнительно копить колонки для локальной аналитики.
+// state != nullptr - инкрементальный режим. false - часть строк не загружена.
+bool runPipelined(PGconn* conn, const EtlOptions& opt, StarSchema* star, EtlState* state) {
+    InputFiles in;
+    bool ok = true;
+
+    InputPlan productsIn = planInput(state, in.products);
+    if (!productsIn.skip) {
+        PipelineStats productStats;
+        bool read = false;
+        ok &= loadProductDim(conn, opt, [&](auto put) {
+            read = runPipeline<Product, Product>(in.products, parseProduct,
+                [&](const Product& in, Product& out) { out = in; return changedRow(state, "products_dim", in); },
+                [&](const Product& p) { addToStar(star, p); put(p); }, productStats, opt.pipeline);
+        });
+        ok &= read;
+        printPipelineStats("products", productStats);
+    }
+
+    InputPlan customersIn = planInput(state, in.customers);
+    if (!customersIn.skip) {
+        PipelineStats customerStats;
+        bool read = false;
+        ok &= loadCustomerDim(conn, opt, [&](auto put) {
+            read = runPipeline<Customer, Customer>(in.customers, parseCustomer,
+                [&](const Customer& in, Customer& out) { out = in; return changedRow(state, "customers_dim", in); },
+                [&](const Customer& c) { addToStar(star, c); put(c); }, customerStats, opt.pipeline);
+        });
+        ok &= read;
+        printPipelineStats("customers", customerStats);
+    }
+
+    InputPlan salesIn = planInput(state, in.sales);
+    if (!salesIn.skip) {
+        FactCheck check(opt.rejectsPath);
+        fetchDimensionKeys(conn, opt, check);
+        RollupDims rollupDims;
+        bool rollup = fetchRollupDims(conn, opt, rollupDims);
+        RollupBatch rollupBatch(rollupDims);
+        BulkLoader salesLoader(conn, "sales_fact", kFactColumns, opt.copy);
+        if (rollup) salesLoader.setHook(&rollupBatch);
+        auto put = rollup ? putRolledFact : putFact;
+        PipelineStats salesStats;
+        PipelineOptions pipeline = opt.pipeline;
+        pipeline.startOffset = salesIn.from;
+        pipeline.onBadRow = [&](std::string_view row) { check.rejects.reject(RejectReason::ParseError, row); };
+        DateSet dates; // заполняется потоком преобразования
+        // Водяной знак читается потоком преобразования, а сдвигается только после загрузки
+        int64_t watermark = state ? state->maxSaleId : INT64_MIN;
+        Fact top{};
+        top.id = INT32_MIN;
+        top.day = INT32_MIN;
+        // Оборванный сжатый файл: загруженное до обрыва остаётся, но файл не запоминается
+        ok &= runPipeline<Sale, Fact>(in.sales, parseSale,
+            [&](const Sale& s, Fact& f) { return s.id > watermark && admitFact(s, f, check) && (dates.add(f.day), true); },
+            [&](const Fact& f) {
+                addToStar(star, f);
+                put(salesLoader, f);
+                top.id = std::max(top.id, f.id);
+                top.day = std::max(top.day, f.day);
+            },
+            salesStats, pipeline);
+        salesLoader.finish();
+        printPipelineStats("sales", salesStats);
+        printLoadStats(salesLoader);
+        if (rollup) printRollupStats(rollupBatch.stats());
+        check.rejects.printSummary();
+        ok &= salesLoader.stats().failed == 0;
+        ok &= loadTimeDim(conn, dates, opt.copy);
+        if (top.id != INT32_MIN) advanceWatermark(state, top);
+    }
+
+    if (state && ok) {
+        state->remember(in.products, productsIn.fp);
+        state->remember(in.customers, customersIn.fp);
+        state->remember(in.sales, salesIn.fp);
+    }
+    return ok;
+}
+
+// Факты (T + L): одним потоком COPY или параллельно по партициям, затем time_dim.
+// each(emit) вызывает emit(const Fact&) для каждого прошедшего проверку факта.
+template <class Each>
+bool loadFacts(PGconn* conn, const char* conninfo, const EtlOptions& opt, StarSchema* star, EtlState* state,
+               size_t expected, Each each) {
+    bool ok = true;
+    DateSet dates;
+    Fact top{};
+    top.id = INT32_MIN;
+    top.day = INT32_MIN;
+    auto note = [&](const Fact& f) {
+        dates.add(f.day);
+        addToStar(star, f);
+        top.id = std::max(top.id, f.id);
+        top.day = std::max(top.day, f.day);
+    };
+    if (star) star->reserve(expected);
+    RollupDims rollupDims;
+    bool rollup = fetchRollupDims(conn, opt, rollupDims);
+    auto put = rollup ? putRolledFact : putFact;
+    if (opt.connections > 1 || opt.scaling) {
+        // Измерения уже загружены - внешние ключи фактов выполнены
+        std::vector<Fact> facts;
+        facts.reserve(expected);
+        each([&](const Fact& f) { facts.push_back(f); note(f); });
+        PgPool pool(conninfo, opt.scaling ? std::max<size_t>(opt.connections, 16) : opt.connections);
+        auto parts = partitionFacts(facts, opt.connections, opt.partitionBy);
+        // Своя RollupBatch на каждый поток загрузки
+        std::deque<RollupBatch> rollups;
+        std::mutex rollupsMu;
+        std::function<void(BulkLoader&)> attach;
+        if (rollup) attach = [&](BulkLoader& loader) {
+            std::lock_guard<std::mutex> lock(rollupsMu);
+            rollups.emplace_back(rollupDims);
+            loader.setHook(&rollups.back());
+        };
+        ParallelLoadStats st = loadPartitions(pool, opt.connections, parts, "sales_fact", kFactColumns,
+                                              opt.copy, opt.retries, put, attach);
+        printParallelStats("sales_fact", st);
+        if (rollup) {
+            RollupStats total;
+            for (const RollupBatch& r : rollups) total += r.stats();
+            printRollupStats(total);
+        }
+        ok &= st.failed == 0;
+        if (opt.scaling) runScaling(conn, pool, facts, opt);
+    } else {
+        RollupBatch rollupBatch(rollupDims);
+        BulkLoader salesLoader(conn, "sales_fact", kFactColumns, opt.copy);
+        if (rollup) salesLoader.setHook(&rollupBatch);
+        each([&](const Fact& f) { put(salesLoader, f); note(f); });
+        salesLoader.finish();
+        printLoadStats(salesLoader);
+        if (rollup) printRollupStats(rollupBatch.stats());
+        ok &= salesLoader.stats().failed == 0;
+    }
+    ok &= loadTimeDim(conn, dates, opt.copy);
+    if (top.id != INT32_MIN) advanceWatermark(state, top);
+    return ok;
+}
+
+// Пакетный режим: файлы читаются целиком, затем загружаются
+bool runBatch(PGconn* conn, const char* conninfo, const EtlOptions& opt, StarSchema* star, EtlState* state) {
+    InputFiles in;
+    bool ok = true;
+    InputPlan productsIn = planInput(state, in.products);
+    InputPlan customersIn = planInput(state, in.customers);
+    InputPlan salesIn = planInput(state, in.sales);
 
     // ETL: Extract
-    auto products = loadProducts("products.csv");
-    auto customers = loadCustomers("customers.csv");
-    auto sales = loadSales("sales.csv");
+    std::vector<Product> products;
+    std::vector<Customer> customers;
+    std::vector<Sale> sales;
+    if (!productsIn.skip) ok &= loadProducts(in.products, products);
+    if (!customersIn.skip) ok &= loadCustomers(in.customers, customers);
+    // Файл отказов перезаписывается, только если факты грузятся: иначе
+    // остаётся файл прошлого запуска
+    FactCheck check(salesIn.skip ? std::string() : opt.rejectsPath);
+    if (!salesIn.skip)
+        ok &= loadSales(in.sales, sales, salesIn.from,
+                        [&](std::string_view row) { check.rejects.reject(RejectReason::ParseError, row); });
 
     std::cout << "📊 Loaded: " << products.size() << " products, "
               << customers.size() << " customers, " << sales.size() << " sales" << std::endl;
 
-    // Load Dimensions (T)
-    for (const auto& p : products) {
-        std::string sql = "INSERT INTO products_dim VALUES (" +
-                         std::to_string(p.id) + ", '" + p.name + "', '" +
-                         p.category + "', " + std::to_string(p.price) +
-                         ") ON CONFLICT DO NOTHING";
-        exec(conn, sql);
+    // Инкрементальный режим: только новые и изменённые строки
+    if (state) {
+        size_t total = products.size();
+        products.erase(std::remove_if(products.begin(), products.end(),
+            [&](const Product& p) { return !changedRow(state, "products_dim", p); }), products.end());
+        size_t totalCustomers = customers.size();
+        customers.erase(std::remove_if(customers.begin(), customers.end(),
+            [&](const Customer& c) { return !changedRow(state, "customers_dim", c); }), customers.end());
+        size_t totalSales = sales.size();
+        sales.erase(std::remove_if(sales.begin(), sales.end(),
+            [&](const Sale& s) { return s.id <= state->maxSaleId; }), sales.end());
+        std::cout << "🔁 Delta: " << products.size() << "/" << total << " products, " << customers.size()
+                  << "/" << totalCustomers << " customers, " << sales.size() << "/" << totalSales
+                  << " sales" << std::endl;
     }
 
-    for (const auto& c : customers) {
-        std::string sql = "INSERT INTO customers_dim VALUES (" +
-                         std::to_string(c.id) + ", '" + c.name + "', '" +
-                         c.region + "') ON CONFLICT DO NOTHING";
-        exec(conn, sql);
-    }
+    // Load Dimensions (T)
+    if (!productsIn.skip)
+        ok &= loadProductDim(conn, opt, [&](auto put) { for (const auto& p : products) { addToStar(star, p); put(p); } });
+    if (!customersIn.skip)
+        ok &= loadCustomerDim(conn, opt, [&](auto put) { for (const auto& c : customers) { addToStar(star, c); put(c); } });
 
     // Load Facts (T + L)
-    for (const auto& s : sales) {
-        std::string date = toDate(s.sale_date_str);
-        if (date.empty()) continue;
+    if (!salesIn.skip) {
+        fetchDimensionKeys(conn, opt, check);
+        ok &= loadFacts(conn, conninfo, opt, star, state, sales.size(), [&](auto emit) {
+            Fact f;
+            for (const auto& s : sales) if (admitFact(s, f, check)) emit(f);
+        });
+        check.rejects.printSummary();
+    }
 
-        std::string sql = "INSERT INTO sales_fact (sale_id, sale_date, product_id, "
-                         "customer_id, quantity, amount) VALUES (" +
-                         std::to_string(s.id) + ", '" + date + "', " +
-                         std::to_string(s.product_id) + ", " +
-                         std::to_string(s.customer_id) + ", " +
-                         std::to_string(s.quantity) + ", " +
-                         std::to_string(s.amount) + ")";
-        exec(conn, sql);
+    if (state && ok) {
+        state->remember(in.products, productsIn.fp);
+        state->remember(in.customers, customersIn.fp);
+        state->remember(in.sales, salesIn.fp);
     }
+    return ok;
+}
 
-    std::cout << "✅ Data loaded!" << std::endl;
+// Снимок: CSV -> колонки -> бинарный файл. База не нужна.
+bool buildSnapshot(const std::string& path) {
+    InputFiles in;
+    auto t0 = std::chrono::steady_clock::now();
+    SnapshotBuilder builder;
+    bool read = scanCsv<Product>(in.products, parseProduct,
+                                 [&](const Product& p) { builder.addProduct(p.id, p.name, p.category, p.price); });
+    read &= scanCsv<Customer>(in.customers, parseCustomer,
+                              [&](const Customer& c) { builder.addCustomer(c.id, c.name, c.region); });
+    read &= scanCsv<Sale>(in.sales, parseSale, [&](const Sale& s) {
+        int32_t day;
+        if (!parseDate(s.sale_date_str, day)) day = kSnapshotBadDay;
+        builder.addSale(s.id, day, s.product_id, s.customer_id, s.quantity, s.amount);
+    });
+    // Неполный снимок не пишем
+    if (!read || !builder.write(path)) return false;
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "💾 Snapshot " << path << ": " << builder.products() << " products, " << builder.customers()
+              << " customers, " << builder.sales() << " sales in " << sec << " s" << std::endl;
+    return true;
+}
 
-    // Analytics
-    std::cout << "\n📈 ANALYTICS:\n";
+std::string formatFact(const Fact& f) {
+    char date[11] = "invalid";
+    if (f.day != kSnapshotBadDay) formatDate(f.day, date);
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "%d,%s,%d,%d,%d,%.15g", f.id, date, f.product_id, f.customer_id,
+                  f.quantity, f.amount);
+    return buf;
+}
 
-    PGresult* res = PQexec(conn,
-        "SELECT p.category, SUM(s.amount) total_sales, COUNT(s.sale_id) cnt "
-        "FROM sales_fact s JOIN products_dim p ON s.product_id = p.product_id "
-        "GROUP BY p.category ORDER BY total_sales DESC");
+Fact snapshotFact(const SnapshotSales& s, size_t i) {
+    return Fact{s.id[i], s.day[i], s.productId[i], s.customerId[i], s.quantity[i], s.amount[i]};
+}
 
+// Без базы: звезда для локальной аналитики прямо из колонок снимка
+void fillStar(StarSchema& star, const SnapshotReader& snap) {
+    const SnapshotProducts& p = snap.products();
+    const SnapshotCustomers& c = snap.customers();
+    const SnapshotSales& s = snap.sales();
+    for (size_t i = 0; i < p.size(); ++i) star.addProduct(p.id[i], p.categories[p.category[i]]);
+    for (size_t i = 0; i < c.size(); ++i) star.addCustomer(c.id[i], c.regions[c.region[i]]);
+    star.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i)
+        if (s.day[i] != kSnapshotBadDay) addToStar(&star, snapshotFact(s, i));
+}
+
+// Загрузка из снимка: колонки читаются прямо из mmap, текст не разбирается
+bool runSnapshot(PGconn* conn, const char* conninfo, const EtlOptions& opt, StarSchema* star,
+                 const SnapshotReader& snap) {
+    bool ok = true;
+    const SnapshotProducts& sp = snap.products();
+    ok &= loadProductDim(conn, opt, [&](auto put) {
+        Product p;
+        for (size_t i = 0; i < sp.size(); ++i) {
+            p.id = sp.id[i];
+            p.name.assign(sp.name[i]);
+            p.category.assign(sp.categories[sp.category[i]]);
+            p.price = sp.price[i];
+            addToStar(star, p);
+            put(p);
+        }
+    });
+    const SnapshotCustomers& sc = snap.customers();
+    ok &= loadCustomerDim(conn, opt, [&](auto put) {
+        Customer c;
+        for (size_t i = 0; i < sc.size(); ++i) {
+            c.id = sc.id[i];
+            c.name.assign(sc.name[i]);
+            c.region.assign(sc.regions[sc.region[i]]);
+            addToStar(star, c);
+            put(c);
+        }
+    });
+
+    FactCheck check(opt.rejectsPath);
+    fetchDimensionKeys(conn, opt, check);
+    const SnapshotSales& ss = snap.sales();
+    ok &= loadFacts(conn, conninfo, opt, star, nullptr, ss.size(), [&](auto emit) {
+        for (size_t i = 0; i < ss.size(); ++i) {
+            Fact f = snapshotFact(ss, i);
+            RejectReason reason = RejectReason::BadDate;
+            if (f.day != kSnapshotBadDay && validKeys(f, check, reason)) emit(f);
+            else check.rejects.reject(reason, formatFact(f));
+        }
+    });
+    check.rejects.printSummary();
+    return ok;
+}
+
+void printQueryGroups(PGconn* conn, const char* sql) {
+    PGresult* res = PQexec(conn, sql);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) std::cerr << "SQL Error: " << PQerrorMessage(conn) << std::endl;
     for (int i = 0; i < PQntuples(res); ++i) {
         std::cout << PQgetvalue(res, i, 0) << ": " << PQgetvalue(res, i, 1)
                   << " (n=" << PQgetvalue(res, i, 2) << ")" << std::endl;
     }
     PQclear(res);
+}
+
+// Аналитика на сервере: вся история sales_fact или её свёртка sales_rollup
+// (сотни строк вместо сканирования всех фактов)
+void printServerAnalytics(PGconn* conn, bool rollup) {
+    if (!rollup) {
+        std::cout << "\n📈 ANALYTICS:\n";
+        printQueryGroups(conn,
+            "SELECT p.category, SUM(s.amount) total_sales, COUNT(s.sale_id) cnt "
+            "FROM sales_fact s JOIN products_dim p ON s.product_id = p.product_id "
+            "GROUP BY p.category ORDER BY total_sales DESC");
+        return;
+    }
+    std::cout << "\n📈 ANALYTICS (sales_rollup):\n-- by category --\n";
+    printQueryGroups(conn,
+        "SELECT category, SUM(total_amount) total_sales, SUM(sales_count) cnt "
+        "FROM sales_rollup GROUP BY category ORDER BY total_sales DESC");
+    std::cout << "-- by region --\n";
+    printQueryGroups(conn,
+        "SELECT region, SUM(total_amount) total_sales, SUM(sales_count) cnt "
+        "FROM sales_rollup GROUP BY region ORDER BY total_sales DESC");
+    std::cout << "-- by month --\n";
+    printQueryGroups(conn,
+        "SELECT to_char(month, 'YYYY-MM'), SUM(total_amount), SUM(sales_count) "
+        "FROM sales_rollup GROUP BY month ORDER BY month");
+}
+
+// Локальная аналитика по колонкам этого запуска: всё прочитанное, в том
+// числе строки откаченных батчей, и без прежней истории таблиц
+void printLocalAnalytics(const StarSchema& star) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto byCategory = star.aggregate(GroupBy::Category);
+    auto byRegion = star.aggregate(GroupBy::Region);
+    auto byMonth = star.aggregate(GroupBy::Month);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "\n📈 ANALYTICS (in-process, " << star.sales().size() << " sales of this run, "
+              << ms << " ms):\n";
+    printGroups("-- by category --", byCategory);
+    printGroups("-- by region --", byRegion);
+    printGroups("-- by month --", byMonth);
+}
+
+// untitled [--binary] [--batch N] [--direct] [--pipeline [--queue N]]
+//          [--connections N] [--partition id|date] [--retries N] [--scaling]
+//          [--dims copy|async] [--sync N] [--bench-insert N]
+//          [--analytics local|server|both] [--incremental [--state FILE]]
+//          [--rejects FILE] [--no-key-check]
+//          [--snapshot-build FILE] [--snapshot FILE [--verify] [--no-load]]
+//          [--rollup] [--rollup-rebuild]
+// --rollup ведёт sales_rollup только по новым фактам; для уже загруженной
+// истории нужен один запуск с --rollup-rebuild.
+EtlOptions parseArgs(int argc, char** argv) {
+    EtlOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--binary")) opt.copy.format = CopyFormat::Binary;
+        else if (!std::strcmp(argv[i], "--batch") && i + 1 < argc) opt.copy.batchSize = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--direct")) opt.copy.skipDuplicates = false;
+        else if (!std::strcmp(argv[i], "--pipeline")) opt.pipelined = true;
+        else if (!std::strcmp(argv[i], "--queue") && i + 1 < argc) opt.pipeline.queueBatches = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--connections") && i + 1 < argc) opt.connections = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--partition") && i + 1 < argc)
+            opt.partitionBy = std::strcmp(argv[++i], "date") ? PartitionBy::Id : PartitionBy::Date;
+        else if (!std::strcmp(argv[i], "--retries") && i + 1 < argc) opt.retries = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--scaling")) opt.scaling = true;
+        else if (!std::strcmp(argv[i], "--dims") && i + 1 < argc) opt.asyncDims = !std::strcmp(argv[++i], "async");
+        else if (!std::strcmp(argv[i], "--sync") && i + 1 < argc) opt.syncEvery = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--bench-insert") && i + 1 < argc) opt.benchInsertRows = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--analytics") && i + 1 < argc) {
+            const char* v = argv[++i];
+            opt.analytics = !std::strcmp(v, "local") ? Analytics::Local
+                          : !std::strcmp(v, "both") ? Analytics::Both : Analytics::Server;
+        }
+        else if (!std::strcmp(argv[i], "--incremental")) opt.incremental = true;
+        else if (!std::strcmp(argv[i], "--state") && i + 1 < argc) opt.statePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--rejects") && i + 1 < argc) opt.rejectsPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--no-key-check")) opt.checkKeys = false;
+        else if (!std::strcmp(argv[i], "--snapshot-build") && i + 1 < argc) opt.snapshotBuild = argv[++i];
+        else if (!std::strcmp(argv[i], "--snapshot") && i + 1 < argc) opt.snapshot = argv[++i];
+        else if (!std::strcmp(argv[i], "--verify")) opt.verifySnapshot = true;
+        else if (!std::strcmp(argv[i], "--no-load")) opt.noLoad = true;
+        else if (!std::strcmp(argv[i], "--rollup")) opt.rollup = true;
+        else if (!std::strcmp(argv[i], "--rollup-rebuild")) opt.rollupRebuild = true;
+        else std::cerr << "Unknown option: " << argv[i] << std::endl;
+    }
+    if (opt.connections == 0) opt.connections = 1;
+    if (opt.pipelined && (opt.connections > 1 || opt.scaling))
+        std::cerr << "--connections/--scaling apply to batch mode only, ignored with --pipeline" << std::endl;
+    if (opt.copy.batchSize == 0) opt.copy.batchSize = 1;
+    if (!opt.snapshot.empty() && (opt.incremental || opt.pipelined)) {
+        std::cerr << "--incremental/--pipeline apply to CSV input only, ignored with --snapshot" << std::endl;
+        opt.incremental = opt.pipelined = false;
+    }
+    if (opt.noLoad && opt.snapshot.empty()) {
+        std::cerr << "--no-load needs --snapshot, ignored" << std::endl;
+        opt.noLoad = false;
+    }
+    if (opt.rollup && opt.rollupRebuild) {
+        std::cerr << "--rollup-rebuild recomputes sales_rollup after the load, --rollup ignored" << std::endl;
+        opt.rollup = false;
+    }
+    return opt;
+}
+
+int main(int argc, char** argv) {
+    EtlOptions opt = parseArgs(argc, argv);
+
+    if (!opt.snapshotBuild.empty()) return buildSnapshot(opt.snapshotBuild) ? 0 : 1;
+
+    SnapshotReader snapshot;
+    if (!opt.snapshot.empty()) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!snapshot.open(opt.snapshot, opt.verifySnapshot)) return 1;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "🗂  Snapshot " << opt.snapshot << ": " << snapshot.products().size() << " products, "
+                  << snapshot.customers().size() << " customers, " << snapshot.sales().size()
+                  << " sales, opened in " << ms << " ms" << std::endl;
+    }
+    if (opt.noLoad) {
+        StarSchema star;
+        fillStar(star, snapshot);
+        printLocalAnalytics(star);
+        return 0;
+    }
+
+    // Замените на свой пароль!
+    const char* conninfo = "host=localhost port=5432 dbname=my_db user=postgres password=mypassword123";
+
+    PGconn* conn = PQconnectdb(conninfo);
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::cerr << "Connection failed: " << PQerrorMessage(conn) << std::endl;
+        PQfinish(conn);
+        return 1;
+    }
+    std::cout << "✅ Connected to my_db!" << std::endl;
+
+    if (opt.benchInsertRows) {
+        runInsertBenchmark(conn, opt.benchInsertRows);
+        PQfinish(conn);
+        return 0;
+    }
+    if (opt.asyncDims && !prepareUpserts(conn, opt.incremental)) {
+        PQfinish(conn);
+        return 1;
+    }
+
+    // По умолчанию - отчёт сервера по всей загруженной истории. Локальный
+    // (--analytics local|both) - быстрый, но только по строкам этого запуска.
+    bool local = opt.analytics == Analytics::Local || opt.analytics == Analytics::Both;
+    bool server = opt.analytics == Analytics::Server || opt.analytics == Analytics::Both;
+    StarSchema star;
+
+    EtlState state;
+    if (opt.incremental) {
+        if (state.load(opt.statePath))
+            std::cout << "🔖 State " << opt.statePath << ": watermark sale_id " << state.maxSaleId << std::endl;
+        else
+            std::cout << "🔖 No state in " << opt.statePath << ", full load" << std::endl;
+    }
+    EtlState* delta = opt.incremental ? &state : nullptr;
+
+    bool ok = !opt.snapshot.empty() ? runSnapshot(conn, conninfo, opt, local ? &star : nullptr, snapshot)
+            : opt.pipelined ? runPipelined(conn, opt, local ? &star : nullptr, delta)
+                            : runBatch(conn, conninfo, opt, local ? &star : nullptr, delta);
+
+    std::cout << "✅ Data loaded!" << std::endl;
+    if (delta) {
+        // Состояние сохраняется только после полностью успешной загрузки,
+        // иначе следующий запуск повторит ту же дельту
+        if (!ok) std::cerr << "Some rows were not loaded, state " << opt.statePath << " not updated" << std::endl;
+        else if (!state.save(opt.statePath)) std::cerr << "Cannot write state " << opt.statePath << std::endl;
+    }
+
+    if (opt.rollupRebuild) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (rebuildRollup(conn)) {
+            double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "🧮 sales_rollup rebuilt from sales_fact in " << sec << " s" << std::endl;
+        }
+    }
+
+    // Analytics
+    if (local) printLocalAnalytics(star);
+    if (server) printServerAnalytics(conn, opt.rollup || opt.rollupRebuild);
 
     PQfinish(conn);
     return 0;
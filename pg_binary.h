@@ -0,0 +1,88 @@
+#pragma once
+
+// Бинарное представление типов Postgres (сетевой порядок байт):
+// общее для COPY (FORMAT binary) и бинарных параметров запросов.
+
+#include <libpq-fe.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+// OID встроенных типов (pg_type.h)
+constexpr Oid kInt4Oid = 23;
+constexpr Oid kTextOid = 25;
+constexpr Oid kFloat8Oid = 701;
+constexpr Oid kDateOid = 1082;
+constexpr Oid kNumericOid = 1700;
+
+// Дни между 1970-01-01 и 2000-01-01 (эпоха дат в бинарном протоколе Postgres)
+constexpr int32_t kPgEpochDays = 10957;
+
+constexpr int64_t kPow10[5] = {1, 10, 100, 1000, 10000};
+
+inline void appendBE16(std::string& out, int16_t v) {
+    uint16_t u = static_cast<uint16_t>(v);
+    char b[2] = {char(u >> 8), char(u)};
+    out.append(b, 2);
+}
+
+inline void storeBE32(char* p, int32_t v) {
+    uint32_t u = static_cast<uint32_t>(v);
+    p[0] = char(u >> 24);
+    p[1] = char(u >> 16);
+    p[2] = char(u >> 8);
+    p[3] = char(u);
+}
+
+inline int32_t loadBE32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<int32_t>(uint32_t(u[0]) << 24 | uint32_t(u[1]) << 16 | uint32_t(u[2]) << 8 | u[3]);
+}
+
+inline void appendBE32(std::string& out, int32_t v) {
+    char b[4];
+    storeBE32(b, v);
+    out.append(b, 4);
+}
+
+inline void appendBE64(std::string& out, int64_t v) {
+    appendBE32(out, static_cast<int32_t>(static_cast<uint64_t>(v) >> 32));
+    appendBE32(out, static_cast<int32_t>(v));
+}
+
+inline void appendFloat8(std::string& out, double v) {
+    int64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    appendBE64(out, bits);
+}
+
+// Число с фиксированной точкой: v * 10^scale, округлённое
+inline int64_t toUnscaled(double v, int scale) { return std::llround(v * kPow10[scale]); }
+
+// Бинарный NUMERIC (без префикса длины): цифры по основанию 10000,
+// weight - степень первой цифры. scale <= 4.
+inline void appendNumeric(std::string& out, int64_t unscaled, int scale) {
+    bool neg = unscaled < 0;
+    uint64_t u = neg ? 0 - static_cast<uint64_t>(unscaled) : static_cast<uint64_t>(unscaled);
+    uint64_t ip = u / kPow10[scale];
+    int16_t frac = static_cast<int16_t>((u % kPow10[scale]) * kPow10[4 - scale]);
+
+    int16_t digits[8];
+    int n = 0;
+    for (uint64_t x = ip; x; x /= 10000) digits[n++] = static_cast<int16_t>(x % 10000);
+    for (int i = 0; i < n / 2; ++i) std::swap(digits[i], digits[n - 1 - i]);
+    int16_t weight = static_cast<int16_t>(n - 1);
+    if (frac) digits[n++] = frac;
+    if (n == 0) weight = 0;
+    else if (ip == 0) weight = -1;
+    while (n > 0 && digits[n - 1] == 0) --n;
+
+    appendBE16(out, static_cast<int16_t>(n));
+    appendBE16(out, weight);
+    appendBE16(out, neg && n ? 0x4000 : 0x0000);
+    appendBE16(out, static_cast<int16_t>(scale));
+    for (int i = 0; i < n; ++i) appendBE16(out, digits[i]);
+}
@@ -0,0 +1,368 @@
+#pragma once
+
+// Потоковая загрузка через COPY ... FROM STDIN (libpq).
+// CopyStream кодирует строки в текстовом или бинарном формате COPY,
+// BulkLoader режет поток на батчи, каждый батч - отдельная транзакция.
+// BatchHook - дополнительная работа в транзакции батча перед COMMIT
+// (например, свёртка по загруженным строкам): фиксируется вместе с батчем.
+
+#include "date_util.h"
+#include "pg_binary.h"
+
+#include <libpq-fe.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+enum class CopyFormat { Text, Binary };
+
+class CopyStream {
+public:
+    explicit CopyStream(CopyFormat format) : format_(format) { buf_.reserve(kFlushBytes + 4096); }
+
+    CopyFormat format() const { return format_; }
+
+    void beginRow(int16_t nfields) {
+        if (format_ == CopyFormat::Binary) putBE16(nfields);
+        first_ = true;
+    }
+
+    void endRow() {
+        if (format_ == CopyFormat::Text) buf_.push_back('\n');
+    }
+
+    void putNull() {
+        if (format_ == CopyFormat::Binary) { putBE32(-1); return; }
+        sep(); buf_ += "\\N";
+    }
+
+    void putInt(int32_t v) {
+        if (format_ == CopyFormat::Binary) { putBE32(4); putBE32(v); return; }
+        sep(); appendInt(v);
+    }
+
+    void putText(std::string_view s) {
+        if (format_ == CopyFormat::Binary) {
+            putBE32(static_cast<int32_t>(s.size()));
+            buf_.append(s.data(), s.size());
+            return;
+        }
+        sep();
+        for (char c : s) {
+            switch (c) {
+                case '\\': buf_ += "\\\\"; break;
+                case '\t': buf_ += "\\t"; break;
+                case '\n': buf_ += "\\n"; break;
+                case '\r': buf_ += "\\r"; break;
+                default: buf_.push_back(c);
+            }
+        }
+    }
+
+    void putInt64(int64_t v) {
+        if (format_ == CopyFormat::Binary) { putBE32(8); appendBE64(buf_, v); return; }
+        sep(); appendInt(v);
+    }
+
+    // NUMERIC с фиксированным числом знаков после запятой (scale <= 4)
+    void putNumeric(double v, int scale = 2) { putUnscaled(toUnscaled(v, scale), scale); }
+
+    // NUMERIC из целого v * 10^scale (например, суммы в копейках)
+    void putUnscaled(int64_t unscaled, int scale = 2) {
+        if (format_ == CopyFormat::Binary) {
+            size_t at = buf_.size();
+            putBE32(0); // длина, заполняется после кодирования
+            appendNumeric(buf_, unscaled, scale);
+            storeBE32(&buf_[at], static_cast<int32_t>(buf_.size() - at - 4));
+            return;
+        }
+        sep();
+        if (unscaled < 0) { buf_.push_back('-'); unscaled = -unscaled; }
+        appendInt(unscaled / kPow10[scale]);
+        if (scale > 0) {
+            buf_.push_back('.');
+            char frac[4];
+            int64_t f = unscaled % kPow10[scale];
+            for (int i = scale - 1; i >= 0; --i) { frac[i] = char('0' + f % 10); f /= 10; }
+            buf_.append(frac, scale);
+        }
+    }
+
+    // Дата как число дней с 1970-01-01
+    void putDate(int32_t daysSinceUnix) {
+        if (format_ == CopyFormat::Binary) { putBE32(4); putBE32(daysSinceUnix - kPgEpochDays); return; }
+        sep();
+        char out[10];
+        formatDate(daysSinceUnix, out);
+        buf_.append(out, 10);
+    }
+
+    void reset() { buf_.clear(); }
+
+    bool start(PGconn* conn, const std::string& copySql) {
+        PGresult* res = PQexec(conn, copySql.c_str());
+        bool ok = PQresultStatus(res) == PGRES_COPY_IN;
+        if (!ok) std::cerr << "COPY Error: " << PQerrorMessage(conn) << std::endl;
+        PQclear(res);
+        if (!ok) return false;
+        conn_ = conn;
+        buf_.clear();
+        if (format_ == CopyFormat::Binary) {
+            buf_.append("PGCOPY\n\377\r\n\0", 11);
+            putBE32(0); // флаги
+            putBE32(0); // длина расширения заголовка
+        }
+        return true;
+    }
+
+    bool flushIfNeeded() { return buf_.size() < kFlushBytes || flush(); }
+
+    // Завершает COPY; возвращает false, если сервер отверг данные
+    bool finish() {
+        if (format_ == CopyFormat::Binary) putBE16(-1);
+        bool ok = flush() && PQputCopyEnd(conn_, nullptr) == 1;
+        PGresult* res;
+        while ((res = PQgetResult(conn_)) != nullptr) {
+            if (PQresultStatus(res) != PGRES_COMMAND_OK) ok = false;
+            PQclear(res);
+        }
+        if (!ok) std::cerr << "COPY Error: " << PQerrorMessage(conn_) << std::endl;
+        return ok;
+    }
+
+    // Прерывает COPY (сервер откатит всё, что уже получил)
+    void abort() {
+        PQputCopyEnd(conn_, "aborted by client");
+        PGresult* res;
+        while ((res = PQgetResult(conn_)) != nullptr) PQclear(res);
+    }
+
+private:
+    static constexpr size_t kFlushBytes = 1 << 20;
+
+    bool flush() {
+        if (buf_.empty()) return true;
+        bool ok = PQputCopyData(conn_, buf_.data(), static_cast<int>(buf_.size())) == 1;
+        buf_.clear();
+        return ok;
+    }
+
+    void sep() {
+        if (!first_) buf_.push_back('\t');
+        first_ = false;
+    }
+
+    void appendInt(int64_t v) {
+        char tmp[24];
+        int n = 0;
+        bool neg = v < 0;
+        uint64_t u = neg ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+        do { tmp[n++] = char('0' + u % 10); u /= 10; } while (u);
+        if (neg) buf_.push_back('-');
+        while (n) buf_.push_back(tmp[--n]);
+    }
+
+    void putBE16(int16_t v) { appendBE16(buf_, v); }
+    void putBE32(int32_t v) { appendBE32(buf_, v); }
+
+    CopyFormat format_;
+    PGconn* conn_ = nullptr;
+    std::string buf_;
+    bool first_ = true;
+};
+
+struct CopyOptions {
+    CopyFormat format = CopyFormat::Text;
+    size_t batchSize = 50000;
+    // true: COPY во временную таблицу + INSERT ... ON CONFLICT DO NOTHING,
+    // повторная загрузка тех же строк не ломает батч
+    bool skipDuplicates = true;
+    // Действие при конфликте для вставки из временной таблицы, например
+    // "(id) DO UPDATE SET name = EXCLUDED.name" - настоящий upsert
+    std::string onConflict = "DO NOTHING";
+};
+
+struct LoadStats {
+    size_t rows = 0;      // строк отправлено
+    size_t inserted = 0;  // строк реально добавлено (или обновлено upsert) сервером
+    size_t failed = 0;    // строк в отвергнутых батчах
+    size_t batches = 0;
+    double seconds = 0;
+
+    double rowsPerSec() const { return seconds > 0 ? rows / seconds : 0; }
+};
+
+class BatchHook {
+public:
+    virtual ~BatchHook() = default;
+
+    // В транзакции батча, после вставки строк. inserted - значения первой
+    // колонки (int4) реально вставленных строк в режиме skipDuplicates,
+    // nullptr - вставлены все строки батча. false - батч откатывается.
+    virtual bool beforeCommit(PGconn* conn, const std::vector<int32_t>* inserted) = 0;
+
+    // Итог батча: зафиксирован или откачен
+    virtual void afterBatch(bool committed) = 0;
+};
+
+class BulkLoader {
+public:
+    // columns - список колонок через запятую в порядке записи полей
+    BulkLoader(PGconn* conn, std::string table, std::string columns, CopyOptions opt = {})
+        : conn_(conn), table_(std::move(table)), columns_(std::move(columns)),
+          opt_(opt), stream_(opt.format) {
+        nfields_ = 1;
+        for (char c : columns_) if (c == ',') ++nfields_;
+        stage_ = "etl_stage_" + table_;
+    }
+
+    ~BulkLoader() {
+        if (!inBatch_) return;
+        rollback();
+        if (hook_) hook_->afterBatch(false);
+    }
+
+    // Начинает строку; поля пишутся напрямую в возвращённый поток
+    CopyStream& beginRow() {
+        if (!inBatch_) startBatch();
+        stream_.beginRow(nfields_);
+        return stream_;
+    }
+
+    void endRow() {
+        stream_.endRow();
+        ++batchRows_;
+        ++stats_.rows;
+        if (batchOk_ && !stream_.flushIfNeeded()) batchOk_ = false;
+        // Строки уже отвергнутого батча не копятся: он всё равно откатится,
+        // а по batchSize закрывается как обычно - дальше идёт новый батч
+        if (!batchOk_) stream_.reset();
+        if (batchRows_ >= opt_.batchSize) commitBatch();
+    }
+
+    const LoadStats& finish() {
+        if (inBatch_) commitBatch();
+        return stats_;
+    }
+
+    // Явно закрывает текущий батч; false - батч откачен
+    bool commit() { return !inBatch_ || commitBatch(); }
+
+    // После PQreset временная таблица сессии пропала - создать заново
+    void reconnected() { stageReady_ = false; }
+
+    // hook не принадлежит загрузчику и должен жить дольше него
+    void setHook(BatchHook* hook) { hook_ = hook; }
+    BatchHook* hook() const { return hook_; }
+
+    const LoadStats& stats() const { return stats_; }
+    const std::string& table() const { return table_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool run(const std::string& sql, size_t* affected = nullptr) {
+        PGresult* res = PQexec(conn_, sql.c_str());
+        bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok) std::cerr << "SQL Error: " << PQerrorMessage(conn_) << std::endl;
+        else if (affected) *affected = std::strtoull(PQcmdTuples(res), nullptr, 10);
+        PQclear(res);
+        return ok;
+    }
+
+    void startBatch() {
+        if (stats_.batches == 0 && stats_.rows == 0) started_ = Clock::now();
+        inBatch_ = true;
+        batchRows_ = 0;
+        batchOk_ = run("BEGIN");
+        if (batchOk_ && opt_.skipDuplicates && !stageReady_) {
+            batchOk_ = run("CREATE TEMP TABLE IF NOT EXISTS " + stage_ + " (LIKE " + table_ +
+                           " INCLUDING DEFAULTS) ON COMMIT DELETE ROWS");
+            stageReady_ = batchOk_;
+        }
+        const std::string& target = opt_.skipDuplicates ? stage_ : table_;
+        std::string sql = "COPY " + target + " (" + columns_ + ") FROM STDIN";
+        if (opt_.format == CopyFormat::Binary) sql += " (FORMAT binary)";
+        if (batchOk_) batchOk_ = stream_.start(conn_, sql);
+        copyOpen_ = batchOk_;
+    }
+
+    bool commitBatch() {
+        bool ok = batchOk_ && stream_.finish();
+        copyOpen_ = false;
+        size_t inserted = batchRows_;
+        std::vector<int32_t> keys;
+        std::string insert = "INSERT INTO " + table_ + " (" + columns_ + ") SELECT " + columns_ + " FROM " +
+                             stage_ + " ON CONFLICT " + opt_.onConflict;
+        if (ok && opt_.skipDuplicates) {
+            if (!hook_) {
+                ok = run(insert, &inserted);
+            } else {
+                ok = insertReturning(insert, keys);
+                inserted = keys.size();
+            }
+        }
+        if (ok && hook_) ok = hook_->beforeCommit(conn_, opt_.skipDuplicates ? &keys : nullptr);
+        if (ok) ok = run("COMMIT");
+        if (hook_) hook_->afterBatch(ok);
+        if (ok) {
+            stats_.inserted += inserted;
+        } else {
+            rollback();
+            stats_.failed += batchRows_;
+            std::cerr << "Batch of " << batchRows_ << " rows into " << table_ << " rolled back" << std::endl;
+        }
+        ++stats_.batches;
+        inBatch_ = false;
+        stats_.seconds = std::chrono::duration<double>(Clock::now() - started_).count();
+        return ok;
+    }
+
+    // Вставка с RETURNING первой колонки (бинарный int4): какие строки вставлены
+    bool insertReturning(const std::string& insert, std::vector<int32_t>& keys) {
+        std::string sql = insert + " RETURNING " + columns_.substr(0, columns_.find(','));
+        PGresult* res = PQexecParams(conn_, sql.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
+        bool ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQftype(res, 0) == kInt4Oid;
+        if (!ok) {
+            std::cerr << "SQL Error: " << PQerrorMessage(conn_) << std::endl;
+        } else {
+            keys.reserve(static_cast<size_t>(PQntuples(res)));
+            for (int i = 0, n = PQntuples(res); i < n; ++i)
+                if (!PQgetisnull(res, i, 0)) keys.push_back(loadBE32(PQgetvalue(res, i, 0)));
+        }
+        PQclear(res);
+        return ok;
+    }
+
+    void rollback() {
+        if (copyOpen_) stream_.abort();
+        stream_.reset();
+        copyOpen_ = false;
+        PQclear(PQexec(conn_, "ROLLBACK"));
+        stageReady_ = false;  // временная таблица могла быть создана в этой транзакции
+    }
+
+    PGconn* conn_;
+    BatchHook* hook_ = nullptr;
+    std::string table_, columns_, stage_;
+    CopyOptions opt_;
+    CopyStream stream_;
+    int16_t nfields_;
+    LoadStats stats_;
+    Clock::time_point started_;
+    size_t batchRows_ = 0;
+    bool inBatch_ = false, batchOk_ = false, copyOpen_ = false, stageReady_ = false;
+};
+
+inline void printLoadStats(const BulkLoader& loader) {
+    const LoadStats& s = loader.stats();
+    std::cout << "📥 " << loader.table() << ": " << s.rows << " rows (" << s.inserted << " new, "
+              << s.failed << " failed) in " << s.batches << " batches, " << s.seconds << " s, "
+              << static_cast<size_t>(s.rowsPerSec()) << " rows/s" << std::endl;
+}
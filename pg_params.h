@@ -0,0 +1,106 @@
+#pragma once
+
+// Параметры запросов libpq (текстовые и бинарные) и подготовленные запросы:
+// PQprepare один раз на таблицу, затем PQexecPrepared / PQsendQueryPrepared
+// без разбора и планирования SQL на каждую строку.
+
+#include "pg_binary.h"
+
+#include <libpq-fe.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Параметры одного запроса; значения хранятся в одном буфере,
+// чтобы запрос можно было переотправить после отката группы
+class PgParams {
+public:
+    void clear() {
+        blob_.clear();
+        offsets_.clear();
+        lengths_.clear();
+        formats_.clear();
+        types_.clear();
+    }
+
+    void addNull(Oid type = 0) { push(-1, 0, 0, type); }
+
+    void addText(std::string_view v, Oid type = 0) {
+        push(static_cast<int>(blob_.size()), static_cast<int>(v.size()), 0, type);
+        blob_.append(v.data(), v.size());
+        blob_.push_back('\0'); // текстовые параметры libpq читает как C-строки
+    }
+
+    // Бинарные параметры: формат 1, тип задан явно
+    void addInt4(int32_t v) {
+        push(static_cast<int>(blob_.size()), 4, 1, kInt4Oid);
+        appendBE32(blob_, v);
+    }
+
+    void addFloat8(double v) {
+        push(static_cast<int>(blob_.size()), 8, 1, kFloat8Oid);
+        appendFloat8(blob_, v);
+    }
+
+    void addNumeric(double v, int scale = 2) {
+        size_t at = blob_.size();
+        appendNumeric(blob_, toUnscaled(v, scale), scale);
+        push(static_cast<int>(at), static_cast<int>(blob_.size() - at), 1, kNumericOid);
+    }
+
+    // Дата - число дней с 1970-01-01
+    void addDate(int32_t daysSinceUnix) {
+        push(static_cast<int>(blob_.size()), 4, 1, kDateOid);
+        appendBE32(blob_, daysSinceUnix - kPgEpochDays);
+    }
+
+    int size() const { return static_cast<int>(offsets_.size()); }
+
+    // Указатели на значения для PQsend*; действительны до изменения параметров
+    void bind(std::vector<const char*>& values) const {
+        values.resize(offsets_.size());
+        for (size_t i = 0; i < offsets_.size(); ++i)
+            values[i] = offsets_[i] < 0 ? nullptr : blob_.data() + offsets_[i];
+    }
+
+    const int* lengths() const { return lengths_.data(); }
+    const int* formats() const { return formats_.data(); }
+    const Oid* types() const { return types_.data(); }
+
+protected:
+    void push(int offset, int length, int format, Oid type) {
+        offsets_.push_back(offset);
+        lengths_.push_back(length);
+        formats_.push_back(format);
+        types_.push_back(type);
+    }
+
+    std::string blob_;
+    std::vector<int> offsets_, lengths_, formats_;
+    std::vector<Oid> types_;
+};
+
+// Подготовка запроса; types - OID параметров (0 - вывести на сервере)
+inline bool prepareStatement(PGconn* conn, const char* name, const char* sql, const std::vector<Oid>& types) {
+    PGresult* res = PQprepare(conn, name, sql, static_cast<int>(types.size()), types.data());
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) std::cerr << "Prepare Error: " << PQerrorMessage(conn) << std::endl;
+    PQclear(res);
+    return ok;
+}
+
+// Синхронное выполнение подготовленного запроса
+inline bool execPrepared(PGconn* conn, const char* name, const PgParams& params) {
+    std::vector<const char*> values;
+    params.bind(values);
+    PGresult* res = PQexecPrepared(conn, name, params.size(), values.data(), params.lengths(),
+                                   params.formats(), 0);
+    ExecStatusType st = PQresultStatus(res);
+    bool ok = st == PGRES_COMMAND_OK || st == PGRES_TUPLES_OK;
+    if (!ok) std::cerr << "SQL Error: " << PQerrorMessage(conn) << std::endl;
+    PQclear(res);
+    return ok;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+// Неблокирующее выполнение запросов в режиме конвейера libpq (PG 14+).
+// Запросы отправляются без ожидания ответов, каждые syncEvery запросов
+// ставится PQpipelineSync - это граница неявной транзакции (группы).
+// Результаты разбираются по мере прихода (опрос PQsocket). Если в группе
+// была ошибка, сервер откатывает всю группу; тогда её запросы повторяются
+// поодиночке, и ошибку получает только виновный запрос.
+// Повторы уходят уже после групп, отправленных следом за откаченной, и могут
+// выполниться после их фиксации: если два запроса пишут одну строку (например,
+// ON CONFLICT DO UPDATE), повтор более старого затрёт более новое значение.
+// Такие потоки нужно либо не смешивать в одном исполнителе, либо ставить syncEvery = 1.
+
+#include "pg_params.h"
+
+#include <libpq-fe.h>
+#include <poll.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct StatementError {
+    size_t seq;          // номер запроса в порядке отправки
+    std::string message;
+};
+
+struct AsyncStats {
+    size_t sent = 0, ok = 0, failed = 0;
+    size_t syncs = 0;         // отправленных точек синхронизации
+    size_t retried = 0;       // запросов, повторённых после отката группы
+    size_t affected = 0;      // сумма PQcmdTuples
+};
+
+class AsyncExecutor {
+public:
+    explicit AsyncExecutor(PGconn* conn, size_t syncEvery = 1000, size_t maxInFlight = 20000)
+        : conn_(conn), syncEvery_(syncEvery ? syncEvery : 1), maxInFlight_(maxInFlight) {}
+
+    ~AsyncExecutor() { if (active_) finish(); }
+
+    bool begin() {
+        if (PQpipelineStatus(conn_) == PQ_PIPELINE_OFF && !PQenterPipelineMode(conn_)) {
+            std::cerr << "Pipeline Error: " << PQerrorMessage(conn_) << std::endl;
+            return false;
+        }
+        PQsetnonblocking(conn_, 1);
+        active_ = true;
+        return true;
+    }
+
+    // Запрос с параметрами (текст SQL уходит в каждом сообщении)
+    size_t send(const std::string& sql, const PgParams& params) {
+        return enqueue(Statement{sql, false, params, seq_++, false});
+    }
+
+    // Запрос, заранее подготовленный через PQprepare
+    size_t sendPrepared(const std::string& name, const PgParams& params) {
+        return enqueue(Statement{name, true, params, seq_++, false});
+    }
+
+    // Отправляет последнюю группу и ждёт все результаты
+    bool finish() {
+        if (!active_) return true;
+        if (!open_.statements.empty()) sync();
+        while (!inflight_.empty() || !retry_.empty()) {
+            drainRetries();
+            if (!pump(true)) break;
+        }
+        abandon("pipeline aborted before the result was received\n");
+        PQsetnonblocking(conn_, 0);
+        bool ok = PQexitPipelineMode(conn_) == 1;
+        if (!ok) std::cerr << "Pipeline Error: " << PQerrorMessage(conn_) << std::endl;
+        active_ = false;
+        return ok && !broken_;
+    }
+
+    const AsyncStats& stats() const { return stats_; }
+    const std::vector<StatementError>& errors() const { return errors_; }
+
+private:
+    struct Statement {
+        std::string command; // SQL или имя подготовленного запроса
+        bool prepared;
+        PgParams params;
+        size_t seq;
+        bool isolated;       // повтор после отката группы - в своей группе
+    };
+
+    struct Group {
+        std::vector<Statement> statements;
+        size_t received = 0;  // запросов, по которым пришли все результаты
+        bool failed = false;
+        size_t affected = 0;
+        std::vector<std::string> messages; // по запросам группы
+    };
+
+    size_t enqueue(Statement st) {
+        size_t seq = st.seq;
+        if (!dispatch(st)) return seq;
+        open_.statements.push_back(std::move(st));
+        if (open_.statements.size() >= syncEvery_) sync();
+        pump(false);
+        // Не больше maxInFlight_ запросов без ответа: ждём, пока сервер догонит
+        while (inFlight_ >= maxInFlight_ && !broken_) {
+            if (inflight_.empty()) sync();  // без точки синхронизации ответов не будет
+            if (!pump(true)) break;
+        }
+        if (!retry_.empty()) drainRetries();
+        return seq;
+    }
+
+    bool dispatch(const Statement& st) {
+        st.params.bind(values_);
+        int rc = st.prepared
+            ? PQsendQueryPrepared(conn_, st.command.c_str(), st.params.size(), values_.data(),
+                                  st.params.lengths(), st.params.formats(), 0)
+            : PQsendQueryParams(conn_, st.command.c_str(), st.params.size(), st.params.types(),
+                                values_.data(), st.params.lengths(), st.params.formats(), 0);
+        if (!rc) {
+            std::cerr << "Pipeline Error: " << PQerrorMessage(conn_) << std::endl;
+            broken_ = true;
+            ++stats_.failed;
+            return false;
+        }
+        ++stats_.sent;
+        ++inFlight_;
+        return true;
+    }
+
+    void sync() {
+        if (!PQpipelineSync(conn_)) {
+            std::cerr << "Pipeline Error: " << PQerrorMessage(conn_) << std::endl;
+            broken_ = true;
+        }
+        ++stats_.syncs;
+        open_.messages.resize(open_.statements.size());
+        inflight_.push_back(std::move(open_));
+        open_ = Group{};
+    }
+
+    // Повтор запросов из откаченных групп: каждый в своей группе
+    void drainRetries() {
+        if (!open_.statements.empty()) sync();
+        while (!retry_.empty()) {
+            Statement st = std::move(retry_.front());
+            retry_.pop_front();
+            st.isolated = true;
+            ++stats_.retried;
+            if (!dispatch(st)) continue;
+            open_.statements.push_back(std::move(st));
+            sync();
+        }
+    }
+
+    // Отправка буфера и разбор готовых результатов; wait - ждать сокет
+    bool pump(bool wait) {
+        if (broken_ && inflight_.empty()) return false;
+        int flush = PQflush(conn_);
+        if (flush < 0) { broken_ = true; return false; }
+        if (wait) {
+            pollfd pfd{PQsocket(conn_), static_cast<short>(POLLIN | (flush ? POLLOUT : 0)), 0};
+            if (poll(&pfd, 1, 1000) < 0) return false;
+        }
+        if (!PQconsumeInput(conn_)) {
+            std::cerr << "Pipeline Error: " << PQerrorMessage(conn_) << std::endl;
+            broken_ = true;
+            abandon(PQerrorMessage(conn_));
+            return false;
+        }
+        while (!inflight_.empty() && !PQisBusy(conn_)) {
+            PGresult* res = PQgetResult(conn_);
+            Group& g = inflight_.front();
+            if (!res) {
+                // конец результатов очередного запроса
+                if (g.received < g.statements.size()) {
+                    ++g.received;
+                    --inFlight_;
+                }
+                continue;
+            }
+            ExecStatusType st = PQresultStatus(res);
+            if (st == PGRES_PIPELINE_SYNC) {
+                PQclear(res);
+                completeGroup(g);
+                inflight_.pop_front();
+                continue;
+            }
+            size_t i = g.received < g.statements.size() ? g.received : g.statements.size() - 1;
+            if (st == PGRES_COMMAND_OK || st == PGRES_TUPLES_OK) {
+                g.affected += std::strtoull(PQcmdTuples(res), nullptr, 10);
+            } else {
+                g.failed = true;
+                if (st != PGRES_PIPELINE_ABORTED) g.messages[i] = PQresultErrorMessage(res);
+            }
+            PQclear(res);
+        }
+        return true;
+    }
+
+    void completeGroup(Group& g) {
+        inFlight_ -= g.statements.size() - g.received;  // запросы без своего конца результатов
+        if (!g.failed) {
+            stats_.ok += g.statements.size();
+            stats_.affected += g.affected;
+            return;
+        }
+        for (size_t i = 0; i < g.statements.size(); ++i) {
+            Statement& st = g.statements[i];
+            if (st.isolated) {
+                ++stats_.failed;
+                errors_.push_back({st.seq, g.messages[i]});
+            } else {
+                retry_.push_back(std::move(st));
+            }
+        }
+    }
+
+    // Соединение потеряно: запросы без результата считаются неудачными, а не пропадают молча
+    void abandon(const std::string& message) {
+        for (Group& g : inflight_)
+            for (const Statement& st : g.statements) {
+                ++stats_.failed;
+                errors_.push_back({st.seq, message});
+            }
+        for (const Statement& st : retry_) {
+            ++stats_.failed;
+            errors_.push_back({st.seq, message});
+        }
+        inflight_.clear();
+        retry_.clear();
+        inFlight_ = open_.statements.size();
+    }
+
+    PGconn* conn_;
+    size_t syncEvery_, maxInFlight_;
+    size_t inFlight_ = 0;  // отправлено, результаты ещё не дочитаны
+    Group open_;
+    std::deque<Group> inflight_;
+    std::deque<Statement> retry_;
+    std::vector<const char*> values_;
+    std::vector<StatementError> errors_;
+    AsyncStats stats_;
+    size_t seq_ = 0;
+    bool active_ = false, broken_ = false;
+};
+
+inline void printAsyncStats(const std::string& name, const AsyncExecutor& ex) {
+    const AsyncStats& s = ex.stats();
+    std::cout << "⚡ " << name << ": " << s.sent << " statements, " << s.ok << " ok, " << s.failed
+              << " failed, " << s.retried << " retried, " << s.syncs << " syncs, "
+              << s.affected << " rows affected" << std::endl;
+    size_t shown = 0;
+    for (const StatementError& e : ex.errors()) {
+        if (++shown > 5) { std::cerr << "   ..." << std::endl; break; }
+        std::cerr << "   #" << e.seq << ": " << e.message;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Небольшой пул соединений libpq: N соединений открываются заранее,
+// потоки берут их через acquire() и возвращают через release().
+
+#include <libpq-fe.h>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class PgPool {
+public:
+    PgPool(const std::string& conninfo, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            PGconn* c = PQconnectdb(conninfo.c_str());
+            if (PQstatus(c) != CONNECTION_OK) {
+                std::cerr << "Connection failed: " << PQerrorMessage(c) << std::endl;
+                PQfinish(c);
+                break;
+            }
+            all_.push_back(c);
+        }
+        idle_ = all_;
+    }
+
+    PgPool(const PgPool&) = delete;
+    PgPool& operator=(const PgPool&) = delete;
+
+    ~PgPool() {
+        for (PGconn* c : all_) PQfinish(c);
+    }
+
+    size_t size() const { return all_.size(); }
+
+    PGconn* acquire() {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [&] { return !idle_.empty(); });
+        PGconn* c = idle_.back();
+        idle_.pop_back();
+        return c;
+    }
+
+    void release(PGconn* c) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            idle_.push_back(c);
+        }
+        cv_.notify_one();
+    }
+
+    // Восстанавливает оборванное соединение; false - сервер недоступен
+    static bool ensureAlive(PGconn* c) {
+        if (PQstatus(c) == CONNECTION_OK) return true;
+        PQreset(c);
+        return PQstatus(c) == CONNECTION_OK;
+    }
+
+private:
+    std::vector<PGconn*> all_, idle_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+};
+
+// Соединение из пула на время области видимости
+class PooledConn {
+public:
+    explicit PooledConn(PgPool& pool) : pool_(pool), conn_(pool.acquire()) {}
+    ~PooledConn() { pool_.release(conn_); }
+    PooledConn(const PooledConn&) = delete;
+    PooledConn& operator=(const PooledConn&) = delete;
+
+    PGconn* get() const { return conn_; }
+
+private:
+    PgPool& pool_;
+    PGconn* conn_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+// Ограниченная lock-free очередь: один производитель, один потребитель.
+// Общая для стадий конвейера ETL и кольца буферов распаковки.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// Ограниченная кольцевая очередь SPSC
+template <class T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        slots_.reset(new T[cap]);
+        mask_ = cap - 1;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    size_t depth() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    bool tryPush(T& v) {
+        size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_.load(std::memory_order_acquire) > mask_) return false;
+        slots_[t & mask_] = std::move(v);
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& v) {
+        size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_.load(std::memory_order_acquire)) return false;
+        v = std::move(slots_[h & mask_]);
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Блокирующие варианты: крутимся, затем уступаем процессор.
+    // pop возвращает false, когда очередь закрыта и пуста.
+    void push(T& v) {
+        for (unsigned spins = 0; !tryPush(v); ++spins) backoff(spins);
+    }
+
+    // Как push, но сдаётся, когда выставлен cancel (потребитель ушёл); false - не положено
+    bool push(T& v, const std::atomic<bool>& cancel) {
+        for (unsigned spins = 0; !tryPush(v); ++spins) {
+            if (cancel.load(std::memory_order_acquire)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    bool pop(T& v) {
+        for (unsigned spins = 0;; ++spins) {
+            if (tryPop(v)) return true;
+            if (closed_.load(std::memory_order_acquire)) return tryPop(v);
+            backoff(spins);
+        }
+    }
+
+    void close() { closed_.store(true, std::memory_order_release); }
+
+private:
+    static void backoff(unsigned spins) {
+        if (spins < 64) return;
+        if (spins < 1024) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::atomic<bool> closed_{false};
+    std::unique_ptr<T[]> slots_;
+    size_t mask_ = 0;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+// Интернированные строки: каждая строка хранится один раз, символы подряд
+// в одном буфере, снаружи - плотный номер (0, 1, 2, ...). Поиск по
+// строке - открытая адресация по номерам, заполнение не выше 1/2.
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class StringPool {
+public:
+    static constexpr uint32_t kMissing = UINT32_MAX;
+
+    uint32_t intern(std::string_view s) {
+        if ((count() + 1) * 2 > slots_.size()) grow();
+        size_t mask = slots_.size() - 1;
+        for (size_t i = hashOf(s) & mask;; i = (i + 1) & mask) {
+            uint32_t id = slots_[i];
+            if (id == kEmpty) {
+                id = static_cast<uint32_t>(count());
+                chars_.append(s.data(), s.size());
+                ends_.push_back(static_cast<uint32_t>(chars_.size()));
+                slots_[i] = id;
+                return id;
+            }
+            if (name(id) == s) return id;
+        }
+    }
+
+    // Номер строки без добавления; kMissing - такой строки нет
+    uint32_t find(std::string_view s) const {
+        if (slots_.empty()) return kMissing;
+        size_t mask = slots_.size() - 1;
+        for (size_t i = hashOf(s) & mask;; i = (i + 1) & mask) {
+            uint32_t id = slots_[i];
+            if (id == kEmpty || name(id) == s) return id;
+        }
+    }
+
+    std::string_view name(uint32_t id) const {
+        uint32_t begin = id ? ends_[id - 1] : 0;
+        return std::string_view(chars_.data() + begin, ends_[id] - begin);
+    }
+
+    size_t count() const { return ends_.size(); }
+    // Сырые данные для записи на диск: символы подряд и конец каждой строки
+    std::string_view chars() const { return chars_; }
+    const std::vector<uint32_t>& ends() const { return ends_; }
+    size_t bytes() const {
+        return chars_.capacity() + ends_.capacity() * sizeof(uint32_t) + slots_.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    static uint64_t hashOf(std::string_view s) {
+        uint64_t h = 1469598103934665603ull; // FNV-1a
+        for (unsigned char c : s) h = (h ^ c) * 1099511628211ull;
+        return h ^ (h >> 29);
+    }
+
+    void grow() {
+        std::vector<uint32_t> slots(std::max<size_t>(slots_.size() * 2, 1024), kEmpty);
+        size_t mask = slots.size() - 1;
+        for (uint32_t id = 0; id < count(); ++id) {
+            size_t i = hashOf(name(id)) & mask;
+            while (slots[i] != kEmpty) i = (i + 1) & mask;
+            slots[i] = id;
+        }
+        slots_.swap(slots);
+    }
+
+    std::string chars_;
+    std::vector<uint32_t> ends_;
+    std::vector<uint32_t> slots_;
+};
@@ -28,6 +28,17 @@ CREATE TABLE IF NOT EXISTS sales_fact (
     amount DECIMAL(10,2) NOT NULL
 );
 
+-- Свёртка продаж по категории, региону и месяцу: ведётся загрузчиком (--rollup)
+CREATE TABLE IF NOT EXISTS sales_rollup (
+    category VARCHAR(100) NOT NULL,
+    region VARCHAR(100) NOT NULL,
+    month DATE NOT NULL,
+    total_amount DECIMAL(18,2) NOT NULL DEFAULT 0,
+    total_quantity BIGINT NOT NULL DEFAULT 0,
+    sales_count BIGINT NOT NULL DEFAULT 0,
+    PRIMARY KEY (category, region, month)
+);
+
 -- Индексы (тоже безопасно)
 DO $$ BEGIN
     CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_sales_product ON sales_fact(product_id);